@@ -0,0 +1,56 @@
+// Batch.cpp : Defines the entry point for the headless batch tool.
+// Triangulates a binary point file without SFML or a window; see batch.h for the file formats
+//
+
+#include "outofcore.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		std::cerr << "Usage: " << argv[0] << " <input.bin> <output.bin> [threads] [edges|triangles] [budget_mb]" << std::endl;
+		return 1;
+	}
+
+	int threads = (argc > 3) ? atoi(argv[3]) : 1;
+	bool triangles = (argc > 4) && strcmp(argv[4], "triangles") == 0;
+	long long budget_mb = (argc > 5) ? atoll(argv[5]) : 0;
+
+	// With a memory budget, sweep the file out of core instead; that only knows how to write triangles
+	if (budget_mb > 0)
+	{
+		if (!triangles)
+		{
+			std::cerr << "A memory budget only works with triangle output" << std::endl;
+			return 1;
+		}
+
+		OutOfCoreStats stats;
+		if (!TriangulateFileOutOfCore(argv[1], argv[2], (size_t)budget_mb << 20, threads, stats))
+		{
+			return 1;
+		}
+
+		std::cout << "Sort (ms): " << stats.sort_ms << std::endl;
+		std::cout << "Triangulate and write (ms): " << stats.triangulate_ms << std::endl;
+		std::cout << "Strips: " << stats.strips << ", most points resident at once: " << stats.max_resident << std::endl;
+		std::cout << "Triangles: " << stats.triangles << std::endl;
+		return 0;
+	}
+
+	StageTimings timings;
+	if (!TriangulateFile(argv[1], argv[2], threads, timings, triangles))
+	{
+		return 1;
+	}
+
+	std::cout << "Map (ms): " << timings.map_ms << std::endl;
+	std::cout << "Sort and load (ms): " << timings.load_ms << std::endl;
+	std::cout << "Triangulate (ms): " << timings.triangulate_ms << std::endl;
+	std::cout << "Write (ms): " << timings.write_ms << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,288 @@
+// Benchmark.cpp : Defines the entry point for the benchmark suite.
+// Times loading, triangulation, the Voronoi pass and the spanning tree separately, over seeded point distributions and sizes
+// Prints one JSON object per line, so results can be collected and compared across commits
+// Built with DELAUNAY_COUNTERS, each line also carries the hot-path counters from the first run; see counters.h
+//
+
+#include "topology.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+//	--------------------------------------------------------
+//	Point distributions
+//	--------------------------------------------------------
+
+// Every generator fills xy with n packed (x, y) records from the given seed, so reruns see identical input
+// They're all unit-square floats, which an integer coordinate build would just flatten to zero
+static_assert(std::is_same<Coord, float>::value, "the benchmark generates float points, so build it with the default coordinate type");
+
+void Uniform(int n, unsigned long long seed, std::vector<float>& xy)
+{
+	std::mt19937_64 rng(seed);
+	std::uniform_real_distribution<float> coordinate(0, 1);
+	for (int i = 0; i < n; i++)
+	{
+		xy.push_back(coordinate(rng));
+		xy.push_back(coordinate(rng));
+	}
+}
+
+void Clustered(int n, unsigned long long seed, std::vector<float>& xy)
+{
+	// Gaussian blobs around a handful of uniformly placed centres
+	std::mt19937_64 rng(seed);
+	std::uniform_real_distribution<float> coordinate(0, 1);
+	int clusters = std::max(1, (int)std::sqrt((double)n) / 10);
+
+	std::vector<float> centres;
+	for (int i = 0; i < clusters; i++)
+	{
+		centres.push_back(coordinate(rng));
+		centres.push_back(coordinate(rng));
+	}
+
+	std::uniform_int_distribution<int> pick(0, clusters - 1);
+	std::normal_distribution<float> spread(0, 0.01f);
+	for (int i = 0; i < n; i++)
+	{
+		int c = pick(rng);
+		xy.push_back(centres[2 * c] + spread(rng));
+		xy.push_back(centres[2 * c + 1] + spread(rng));
+	}
+}
+
+void Lattice(int n, unsigned long long seed, std::vector<float>& xy)
+{
+	// A square integer grid, shuffled; every cell is four co-circular points, which is as degenerate as it gets
+	int side = std::max(2, (int)std::ceil(std::sqrt((double)n)));
+	std::vector<int> cells(side * side);
+	for (int i = 0; i < cells.size(); i++)
+	{
+		cells[i] = i;
+	}
+
+	std::mt19937_64 rng(seed);
+	std::shuffle(cells.begin(), cells.end(), rng);
+	for (int i = 0; i < n; i++)
+	{
+		xy.push_back(cells[i] % side);
+		xy.push_back(cells[i] / side);
+	}
+}
+
+void Collinear(int n, unsigned long long seed, std::vector<float>& xy)
+{
+	// Everything on the line y = 2x + 1, at distinct integer x
+	std::mt19937_64 rng(seed);
+	std::uniform_int_distribution<int> coordinate(0, 4 * n);
+	for (int i = 0; i < n; i++)
+	{
+		int x = coordinate(rng);
+		xy.push_back(x);
+		xy.push_back(2 * x + 1);
+	}
+}
+
+void Cocircular(int n, unsigned long long seed, std::vector<float>& xy)
+{
+	// Everything on one circle, give or take float rounding, so nearly every in-circle test goes to the exact path
+	std::mt19937_64 rng(seed);
+	std::uniform_real_distribution<double> angle(0, 2 * 3.14159265358979323846);
+	for (int i = 0; i < n; i++)
+	{
+		double t = angle(rng);
+		xy.push_back(1000 * std::cos(t));
+		xy.push_back(1000 * std::sin(t));
+	}
+}
+
+void LargeCoordinates(int n, unsigned long long seed, std::vector<float>& xy)
+{
+	// A uniform patch a long way from the origin, where float spacing is coarse and the lifted terms are huge
+	std::mt19937_64 rng(seed);
+	std::uniform_real_distribution<float> coordinate(0, 1e6f);
+	for (int i = 0; i < n; i++)
+	{
+		xy.push_back(1e7f + coordinate(rng));
+		xy.push_back(-3e7f + coordinate(rng));
+	}
+}
+
+struct Distribution
+{
+	const char*											name;
+	void												(*generate)(int n, unsigned long long seed, std::vector<float>& xy);
+};
+
+const Distribution DISTRIBUTIONS[] =
+{
+	{ "uniform", Uniform },
+	{ "clustered", Clustered },
+	{ "lattice", Lattice },
+	{ "collinear", Collinear },
+	{ "cocircular", Cocircular },
+	{ "large", LargeCoordinates },
+};
+
+//	--------------------------------------------------------
+//	Timing
+//	--------------------------------------------------------
+
+// What one run over one input measured, in milliseconds
+struct Sample
+{
+	double												load_ms;
+	double												triangulate_ms;
+	double												voronoi_ms;
+	double												mst_ms;
+	long long											vertices;
+	long long											edges;
+	unsigned long long									orient_exact;
+	unsigned long long									incircle_exact;
+	std::string											counters;
+};
+
+double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+Sample Run(const std::vector<float>& xy, int threads, bool alternate)
+{
+	Sample sample;
+	PREDICATE_STATS.orient_exact = 0;
+	PREDICATE_STATS.incircle_exact = 0;
+#ifdef DELAUNAY_COUNTERS
+	COUNTERS.Reset();
+#endif
+
+	auto start = std::chrono::high_resolution_clock::now();
+	Delaunay del(xy.data(), xy.size() / 2);
+	sample.load_ms = MillisecondsSince(start);
+	sample.vertices = del.GetSources().size();
+	del.SetAlternatingCuts(alternate);
+
+	start = std::chrono::high_resolution_clock::now();
+	QuadList quads = del.GetTriangulation(threads);
+	sample.triangulate_ms = MillisecondsSince(start);
+	sample.edges = quads.size();
+	sample.orient_exact = PREDICATE_STATS.orient_exact;
+	sample.incircle_exact = PREDICATE_STATS.incircle_exact;
+#ifdef DELAUNAY_COUNTERS
+	std::ostringstream counters;
+	COUNTERS.WriteJson(counters);
+	sample.counters = counters.str();
+#endif
+
+	start = std::chrono::high_resolution_clock::now();
+	del.GetVoronoi(threads);
+	sample.voronoi_ms = MillisecondsSince(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	del.GetMST(threads);
+	sample.mst_ms = MillisecondsSince(start);
+
+	return sample;
+}
+
+double Median(std::vector<double> values)
+{
+	std::sort(values.begin(), values.end());
+	return values[values.size() / 2];
+}
+
+void Report(const std::string& label, const char* distribution, int n, unsigned long long seed, int threads, bool alternate, const std::vector<Sample>& samples)
+{
+	// Minimum and median over the repetitions for each stage; counts come from the first run, since every run sees the same input
+	std::vector<double> load, triangulate, voronoi, mst;
+	for (auto i = samples.begin(); i != samples.end(); i++)
+	{
+		load.push_back(i->load_ms);
+		triangulate.push_back(i->triangulate_ms);
+		voronoi.push_back(i->voronoi_ms);
+		mst.push_back(i->mst_ms);
+	}
+
+	std::cout << "{\"label\":\"" << label << "\",\"distribution\":\"" << distribution << "\",\"n\":" << n
+		<< ",\"seed\":" << seed << ",\"threads\":" << threads << ",\"cuts\":\"" << (alternate ? "alternating" : "vertical") << "\",\"reps\":" << samples.size()
+		<< ",\"vertices\":" << samples[0].vertices << ",\"edges\":" << samples[0].edges
+		<< ",\"orient_exact\":" << samples[0].orient_exact << ",\"incircle_exact\":" << samples[0].incircle_exact
+		<< ",\"load_ms\":{\"min\":" << *std::min_element(load.begin(), load.end()) << ",\"median\":" << Median(load) << "}"
+		<< ",\"triangulate_ms\":{\"min\":" << *std::min_element(triangulate.begin(), triangulate.end()) << ",\"median\":" << Median(triangulate) << "}"
+		<< ",\"voronoi_ms\":{\"min\":" << *std::min_element(voronoi.begin(), voronoi.end()) << ",\"median\":" << Median(voronoi) << "}"
+		<< ",\"mst_ms\":{\"min\":" << *std::min_element(mst.begin(), mst.end()) << ",\"median\":" << Median(mst) << "}";
+	if (!samples[0].counters.empty())
+	{
+		std::cout << ",\"counters\":" << samples[0].counters;
+	}
+	std::cout << "}" << std::endl;
+}
+
+//	--------------------------------------------------------
+//	Entry point
+//	--------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+	// Sizes go up by powers of ten from min to max
+	// The full 1e8 sweep needs tens of gigabytes, so the default stops well short of that
+	long long min_n = 1000;
+	long long max_n = 1000000;
+	unsigned long long seed = 1;
+	int threads = 1;
+	int reps = 3;
+	std::string label = "";
+	std::string only = "";
+	bool alternate = false;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--min") == 0)				min_n = atoll(argv[i + 1]);
+		else if (strcmp(argv[i], "--max") == 0)			max_n = atoll(argv[i + 1]);
+		else if (strcmp(argv[i], "--seed") == 0)		seed = strtoull(argv[i + 1], nullptr, 10);
+		else if (strcmp(argv[i], "--threads") == 0)		threads = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--reps") == 0)		reps = std::max(1, atoi(argv[i + 1]));
+		else if (strcmp(argv[i], "--label") == 0)		label = argv[i + 1];
+		else if (strcmp(argv[i], "--dist") == 0)		only = argv[i + 1];
+		else if (strcmp(argv[i], "--cuts") == 0)		alternate = strcmp(argv[i + 1], "alternating") == 0;
+		else
+		{
+			std::cerr << "Usage: " << argv[0] << " [--min n] [--max n] [--seed s] [--threads t] [--reps r] [--label text] [--dist name] [--cuts vertical|alternating]" << std::endl;
+			return 1;
+		}
+	}
+
+	for (const Distribution& distribution : DISTRIBUTIONS)
+	{
+		if (!only.empty() && only != distribution.name)
+		{
+			continue;
+		}
+
+		for (long long n = min_n; n <= max_n; n *= 10)
+		{
+			std::vector<float> xy;
+			xy.reserve(2 * n);
+			distribution.generate(n, seed, xy);
+
+			std::vector<Sample> samples;
+			for (int r = 0; r < reps; r++)
+			{
+				samples.push_back(Run(xy, threads, alternate));
+			}
+
+			Report(label, distribution.name, n, seed, threads, alternate, samples);
+		}
+	}
+
+	return 0;
+}
@@ -2,7 +2,11 @@
 //
 
 #include "stdafx.h"
+
+// The demo only ever has whole pixel coordinates, so it can use the exact integer predicates
+#define DELAUNAY_COORD_INT32
 #include "topology.h"
+#include <SFML/Graphics.hpp>
 #include <iostream>
 #include <chrono>
 
@@ -10,77 +14,86 @@ bool DRAW_DELAUNAY = false;
 bool DRAW_VORONOI = false;
 bool DRAW_MST = false;
 
-void DrawEdge(Edge* e, sf::RenderWindow& window, const sf::Color& color)
+// Every layer is one vertex array of line segments, built once and then drawn with a single call per frame
+// Call BuildLayers again whenever the triangulation changes; nothing in the frame loop touches the mesh
+struct Layers
 {
-	Edge* sym = e->Sym();
-	Vert* destination = e->destination();
-	Vert org = *(e->origin());
-	Vert dest = *(e->destination());
-
-	sf::VertexArray v(sf::Lines, 2);
+	sf::VertexArray delaunay;
+	sf::VertexArray voronoi;
+	sf::VertexArray mst;
+};
 
-	v[0].position = sf::Vector2f(org.x(), org.y());
-	v[0].color = color;
-	v[1].position = sf::Vector2f(dest.x(), dest.y());
-	v[1].color = color;
-
-	window.draw(v);
+void SetLine(sf::VertexArray& lines, int& count, Vert* org, Vert* dest, const sf::Color& color)
+{
+	lines[count].position = sf::Vector2f(org->x(), org->y());
+	lines[count++].color = color;
+	lines[count].position = sf::Vector2f(dest->x(), dest->y());
+	lines[count++].color = color;
 }
 
-void DrawVoronoi(Edge* e, sf::RenderWindow& window)
+void BuildLayers(const QuadList& quads, const EdgeList& mst, Layers& layers)
 {
-	sf::VertexArray v(sf::Lines, 2);
-
-	Vert* org = e[1].origin();
-	Vert* dest = e[3].origin();
+	// Size every layer for the worst case up front, then trim it to what actually got filled in
+	int delaunay = 0;
+	int voronoi = 0;
+	int tree = 0;
+
+	layers.delaunay.setPrimitiveType(sf::Lines);
+	layers.voronoi.setPrimitiveType(sf::Lines);
+	layers.mst.setPrimitiveType(sf::Lines);
+	layers.delaunay.resize(DRAW_DELAUNAY ? 2 * quads.size() : 0);
+	layers.voronoi.resize(DRAW_VORONOI ? 2 * quads.size() : 0);
+	layers.mst.resize(DRAW_MST ? 2 * mst.size() : 0);
+
+	for (auto i = quads.begin(); i != quads.end(); ++i)
+	{
+		Edge* e = (*i)->edges;
+		if (DRAW_DELAUNAY && e[0].draw)
+		{
+			SetLine(layers.delaunay, delaunay, e[0].origin(), e[0].destination(), sf::Color::White);
+		}
+		if (DRAW_VORONOI && e[1].draw)
+		{
+			SetLine(layers.voronoi, voronoi, e[1].origin(), e[3].origin(), sf::Color::Green);
+		}
+	}
 
-	v[0].position = sf::Vector2f(org->x(), org->y());
-	v[0].color = sf::Color::Green;
-	v[1].position = sf::Vector2f(dest->x(), dest->y());
-	v[1].color = sf::Color::Green;
+	for (auto i = mst.begin(); i != mst.end(); ++i)
+	{
+		if (DRAW_MST && (*i)->draw)
+		{
+			SetLine(layers.mst, tree, (*i)->origin(), (*i)->destination(), sf::Color::Red);
+		}
+	}
 
-	window.draw(v);
+	layers.delaunay.resize(delaunay);
+	layers.voronoi.resize(voronoi);
+	layers.mst.resize(tree);
 }
 
-void Render(QuadList& quads, EdgeList& mst)
+void Render(const Layers& layers)
 {
 	// Build the remdering environment
 	sf::RenderWindow window(sf::VideoMode(512, 512), "Delaunay Triangulator");
 
-	// Turn the vertices into something we want to render
-	std::vector<std::tuple<sf::Vector2f, sf::Vector2f>> quads_debug;
-	for (int i = 0; i < quads.size(); i++)
-	{
-		sf::Vector2f a(quads[i]->edges[0].origin()->x(), quads[i]->edges[0].origin()->y());
-		sf::Vector2f b(quads[i]->edges[2].origin()->x(), quads[i]->edges[2].origin()->y());
-		quads_debug.push_back(std::make_tuple(a, b));
-		//quads_debug.push_back(std::make_tuple(quads[i]->edges[1].origin()->getPosition(), quads[i]->edges[3].origin()->getPosition()));
-	}
-
 	// Rendering loop
 	while (window.isOpen())
 	{
-		window.clear();
-
-		for (auto i = quads.begin(); i != quads.end(); ++i)
+		sf::Event event;
+		while (window.pollEvent(event))
 		{
-			if (DRAW_DELAUNAY && (*i)->edges[0].draw)
-			{
-				DrawEdge((*i)->edges, window, sf::Color::White);
-			}
-			if (DRAW_VORONOI && (*i)->edges[1].draw)
+			if (event.type == sf::Event::Closed)
 			{
-				DrawVoronoi((*i)->edges, window);
+				window.close();
 			}
 		}
 
-		for (auto i = mst.begin(); i != mst.end(); ++i)
-		{
-			if (DRAW_MST && (*i)->draw)
-			{
-				DrawEdge((*i), window, sf::Color::Red);
-			}
-		}
+		window.clear();
+
+		// Three draw calls a frame, however many edges there are
+		window.draw(layers.delaunay);
+		window.draw(layers.voronoi);
+		window.draw(layers.mst);
 
 		window.display();
 	}
@@ -124,7 +137,9 @@ int _tmain(int argc, _TCHAR* argv[])
 
 	std::cout << "Running time (ms): " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() << std::endl;
 
-	Render(quads, mst);
+	Layers layers;
+	BuildLayers(quads, mst, layers);
+	Render(layers);
 
 	return 0;
 }
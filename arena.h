@@ -0,0 +1,185 @@
+//	--------------------------------------------------------
+//	ARENA.H
+//	--------------------------------------------------------
+//	Contains a slab allocator for the small, numerous objects the triangulation churns through
+//	Objects are carved out of big blocks, recycled through a free list, and released all at once
+//	--------------------------------------------------------
+
+#ifndef ARENA_H
+#define ARENA_H
+
+//	--------------------------------------------------------
+//	Include
+//	--------------------------------------------------------
+
+#include <new>
+#include <utility>
+#include <vector>
+
+//	--------------------------------------------------------
+//	The Pool class
+//	--------------------------------------------------------
+
+// One pool per object type; Make() and Release() stand in for new and delete
+// Bulk release skips destructors, so only put things in here that don't own anything (Vert, QuadEdge)
+template <typename T>
+class Pool
+{
+private:
+	// A slot either holds a live object or links to the next free slot
+	union Slot
+	{
+		Slot*											next;
+		alignas(T) unsigned char						storage[sizeof(T)];
+	};
+
+	std::vector<Slot*>									blocks_;
+	Slot*												free_;
+	int													current_;
+	int													used_;
+	int													block_size_;
+	int													live_;
+
+public:
+	Pool(int block_size = 1024);
+	~Pool();
+
+	// Copying would double-free the blocks
+	Pool(const Pool&) = delete;
+	Pool& operator=(const Pool&) = delete;
+
+	template <typename... Args>
+	T*													Make(Args&&... args);
+	void												Release(T* object);
+	void												Clear();
+
+	// Like Clear, except the blocks stay allocated and every slot in them is up for grabs again
+	void												Reset();
+
+	// Take over all of another pool's blocks, live objects and free slots included
+	void												Adopt(Pool& other);
+
+	int													live()									{ return live_; };
+};
+
+//	--------------------------------------------------------
+//	Constructors and destructors
+//	--------------------------------------------------------
+
+template <typename T>
+Pool<T>::Pool(int block_size) : free_(nullptr), current_(-1), used_(block_size), block_size_(block_size), live_(0)
+{
+}
+
+template <typename T>
+Pool<T>::~Pool()
+{
+	Clear();
+}
+
+//	--------------------------------------------------------
+//	Member functions
+//	--------------------------------------------------------
+
+template <typename T>
+template <typename... Args>
+T* Pool<T>::Make(Args&&... args)
+{
+	Slot* slot;
+
+	if (free_ != nullptr)
+	{
+		// Recycle something that was released earlier
+		slot = free_;
+		free_ = free_->next;
+	}
+	else
+	{
+		// Otherwise bump along the current block, moving on to the next one when it runs out (there's only a next one after a Reset)
+		if (used_ == block_size_)
+		{
+			if (current_ + 1 == blocks_.size())
+			{
+				blocks_.push_back(new Slot[block_size_]);
+			}
+			current_++;
+			used_ = 0;
+		}
+		slot = blocks_[current_] + used_;
+		used_++;
+	}
+
+	live_++;
+	return new (slot->storage) T(std::forward<Args>(args)...);
+}
+
+template <typename T>
+void Pool<T>::Release(T* object)
+{
+	// Tear the object down and thread its slot onto the free list
+	object->~T();
+	Slot* slot = reinterpret_cast<Slot*>(object);
+	slot->next = free_;
+	free_ = slot;
+	live_--;
+}
+
+template <typename T>
+void Pool<T>::Clear()
+{
+	// Hand every block back in one go; anything still pointing in here is now dangling
+	for (auto i = blocks_.begin(); i != blocks_.end(); i++)
+	{
+		delete[] *i;
+	}
+
+	blocks_.clear();
+	free_ = nullptr;
+	current_ = -1;
+	used_ = block_size_;
+	live_ = 0;
+}
+
+template <typename T>
+void Pool<T>::Reset()
+{
+	// Just start bumping from the first block again; that's constant time however many blocks there are
+	// (Every block is block_size_ long, adopted ones included, since nobody makes pools of one type with different sizes)
+	free_ = nullptr;
+	current_ = blocks_.empty() ? -1 : 0;
+	used_ = blocks_.empty() ? block_size_ : 0;
+	live_ = 0;
+}
+
+template <typename T>
+void Pool<T>::Adopt(Pool& other)
+{
+	// Slide the other blocks in at the front, so the block we're bumping along stays the same one
+	blocks_.insert(blocks_.begin(), other.blocks_.begin(), other.blocks_.end());
+	current_ += other.blocks_.size();
+
+	// Tack their free list onto ours
+	if (other.free_ != nullptr)
+	{
+		Slot* tail = other.free_;
+		while (tail->next != nullptr)
+		{
+			tail = tail->next;
+		}
+		tail->next = free_;
+		free_ = other.free_;
+	}
+
+	live_ += other.live_;
+
+	// Leave the other pool empty so it doesn't free anything out from under us
+	other.blocks_.clear();
+	other.free_ = nullptr;
+	other.current_ = -1;
+	other.used_ = other.block_size_;
+	other.live_ = 0;
+}
+
+//	--------------------------------------------------------
+
+#endif
@@ -0,0 +1,180 @@
+//	--------------------------------------------------------
+//	BATCH.H
+//	--------------------------------------------------------
+//	Contains the headless entry point: triangulate a binary point file and stream the result back out, no window required
+//	--------------------------------------------------------
+//
+//	Input file: packed (x, y) records, each two little-endian 32-bit floats, and nothing else
+//	Output file: a little-endian uint64 edge count, then that many (uint32, uint32) pairs
+//	Each pair is the input record indices of an edge's endpoints; duplicate points all map to their first record
+//	Or, asking for triangles: a uint64 triangle count, then that many (uint32, uint32, uint32) counterclockwise corners, indexed the same way
+//
+//	--------------------------------------------------------
+
+#ifndef BATCH_H
+#define BATCH_H
+
+//	--------------------------------------------------------
+//	Include
+//	--------------------------------------------------------
+
+#include "mapfile.h"
+#include "topology.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+// The file formats are float records, and the mapped file is handed straight to the triangulation
+static_assert(std::is_same<Coord, float>::value, "the batch tools read float records, so build them with the default coordinate type");
+
+//	--------------------------------------------------------
+//	Timings
+//	--------------------------------------------------------
+
+// Wall-clock milliseconds spent in each stage of TriangulateFile
+struct StageTimings
+{
+	double												map_ms;
+	double												load_ms;
+	double												triangulate_ms;
+	double												write_ms;
+};
+
+//	--------------------------------------------------------
+//	Helpers
+//	--------------------------------------------------------
+
+double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Collects fixed-size records and hands them to fwrite a big chunk at a time
+class ChunkWriter
+{
+private:
+	FILE*												file_;
+	std::vector<uint32_t>								buffer_;
+	bool												ok_;
+
+public:
+	ChunkWriter(FILE* file) : file_(file), ok_(true)							{ buffer_.reserve(1 << 16); };
+
+	void												Put(uint32_t value);
+	void												Flush();
+	bool												ok()									{ return ok_; };
+};
+
+void ChunkWriter::Put(uint32_t value)
+{
+	buffer_.push_back(value);
+	if (buffer_.size() == buffer_.capacity())
+	{
+		Flush();
+	}
+}
+
+void ChunkWriter::Flush()
+{
+	if (!buffer_.empty() && fwrite(buffer_.data(), sizeof(uint32_t), buffer_.size(), file_) != buffer_.size())
+	{
+		ok_ = false;
+	}
+	buffer_.clear();
+}
+
+//	--------------------------------------------------------
+//	The entry point
+//	--------------------------------------------------------
+
+// Returns false (and says why on std::cerr) if either file can't be used
+// threads > 1 uses the parallel triangulation (and the parallel triangle export)
+bool TriangulateFile(const char* input_path, const char* output_path, int threads, StageTimings& timings, bool triangles = false)
+{
+	timings = StageTimings();
+
+	// Map the input; the points get read straight out of the page cache
+	auto start = std::chrono::high_resolution_clock::now();
+	MappedFile input;
+	if (!input.Open(input_path))
+	{
+		std::cerr << "Couldn't map " << input_path << std::endl;
+		return false;
+	}
+	if (input.size() % (2 * sizeof(float)) != 0)
+	{
+		std::cerr << input_path << " isn't a whole number of (x, y) float records" << std::endl;
+		return false;
+	}
+	// Delaunay counts records in an int, so anything bigger has to go through the out-of-core path instead
+	uint64_t records = input.size() / (2 * sizeof(float));
+	if (records > 0x7FFFFFFFull)
+	{
+		std::cerr << input_path << " has more records than the in-memory path can count; give a memory budget to sweep it out of core" << std::endl;
+		return false;
+	}
+	int count = (int)records;
+	timings.map_ms = MillisecondsSince(start);
+
+	// Sort and dedupe in place; nothing gets copied out of the mapping except one Vert per distinct point
+	start = std::chrono::high_resolution_clock::now();
+	Delaunay del((const float*)input.data(), count);
+	const std::vector<int>& sources = del.GetSources();
+	timings.load_ms = MillisecondsSince(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	QuadList quads = del.GetTriangulation(threads);
+	timings.triangulate_ms = MillisecondsSince(start);
+
+	// Stream the edges out as pairs of input record indices
+	start = std::chrono::high_resolution_clock::now();
+	FILE* output = fopen(output_path, "wb");
+	if (output == nullptr)
+	{
+		std::cerr << "Couldn't open " << output_path << " for writing" << std::endl;
+		return false;
+	}
+
+	bool ok;
+	ChunkWriter writer(output);
+	if (triangles)
+	{
+		std::vector<int> indices;
+		del.GetTriangles(indices, threads);
+
+		uint64_t triangle_count = indices.size() / 3;
+		ok = fwrite(&triangle_count, sizeof(triangle_count), 1, output) == 1;
+		for (auto i = indices.begin(); i != indices.end(); i++)
+		{
+			writer.Put(sources[*i]);
+		}
+	}
+	else
+	{
+		uint64_t edge_count = quads.size();
+		ok = fwrite(&edge_count, sizeof(edge_count), 1, output) == 1;
+		for (auto i = quads.begin(); i != quads.end(); i++)
+		{
+			writer.Put(sources[(*i)->edges[0].origin()->id()]);
+			writer.Put(sources[(*i)->edges[0].destination()->id()]);
+		}
+	}
+	writer.Flush();
+
+	ok = ok && writer.ok();
+	ok = (fclose(output) == 0) && ok;
+	timings.write_ms = MillisecondsSince(start);
+
+	if (!ok)
+	{
+		std::cerr << "Couldn't finish writing " << output_path << std::endl;
+	}
+	return ok;
+}
+
+//	--------------------------------------------------------
+
+#endif
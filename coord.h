@@ -0,0 +1,70 @@
+//	--------------------------------------------------------
+//	COORD.H
+//	--------------------------------------------------------
+//	Contains the coordinate type every Vert is stored in
+//	Build with one of DELAUNAY_COORD_INT32, DELAUNAY_COORD_INT64 or DELAUNAY_COORD_DOUBLE defined to change it; the default is float
+//	--------------------------------------------------------
+
+#ifndef COORD_H
+#define COORD_H
+
+//	--------------------------------------------------------
+//	Include
+//	--------------------------------------------------------
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+//	--------------------------------------------------------
+//	The type
+//	--------------------------------------------------------
+
+// Integer coordinates get exact predicates with no floating point in them at all (see predicates.h), which is what
+// pixel grids want; float and double go through the filtered floating-point ones
+#if defined(DELAUNAY_COORD_INT32)
+typedef int32_t Coord;
+#elif defined(DELAUNAY_COORD_INT64)
+typedef int64_t Coord;
+#elif defined(DELAUNAY_COORD_DOUBLE)
+typedef double Coord;
+#else
+typedef float Coord;
+#endif
+
+//	--------------------------------------------------------
+//	Conversions
+//	--------------------------------------------------------
+
+// Derived positions, like circumcenters, are computed in double and have to come back to Coord somehow
+// Integers round to the nearest grid point, clamped so a near-degenerate triangle can't overflow them; that's the price of storing Voronoi vertices as Verts
+Coord CoordFromDouble(double v)
+{
+	if (!std::is_integral<Coord>::value)
+	{
+		return (Coord)v;
+	}
+
+	if (!(v == v))
+	{
+		return 0;
+	}
+
+	const double low = (double)std::numeric_limits<Coord>::min();
+	const double high = (double)std::numeric_limits<Coord>::max();
+	if (v <= low)
+	{
+		return std::numeric_limits<Coord>::min();
+	}
+	if (v >= high)
+	{
+		return std::numeric_limits<Coord>::max();
+	}
+
+	return (Coord)std::llround(v);
+}
+
+//	--------------------------------------------------------
+
+#endif
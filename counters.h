@@ -0,0 +1,199 @@
+//	--------------------------------------------------------
+//	COUNTERS.H
+//	--------------------------------------------------------
+//	Contains optional instrumentation for the hot paths: call counts for the predicates and topology operations,
+//	plus per-recursion-depth statistics from the merges
+//	Build with DELAUNAY_COUNTERS defined to turn it on; otherwise every macro here expands to nothing
+//	--------------------------------------------------------
+
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#ifdef DELAUNAY_COUNTERS
+
+//	--------------------------------------------------------
+//	Include
+//	--------------------------------------------------------
+
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+//	--------------------------------------------------------
+//	What gets counted
+//	--------------------------------------------------------
+
+enum CounterKind
+{
+	COUNT_INCIRCLE,
+	COUNT_CCW,
+	COUNT_SPLICE,
+	COUNT_CONNECT,
+	COUNT_KILL,
+	COUNT_MAKE_EDGE,
+	COUNTER_KINDS
+};
+
+const char* const COUNTER_NAMES[COUNTER_KINDS] = { "incircle", "ccw", "splice", "connect", "kill", "make_edge" };
+
+// Deeper than this and everything lands in the last bucket; a balanced split on 2^40 points still fits
+const int COUNTER_DEPTHS = 48;
+
+// One of these per thread, so bumping a counter is a plain increment with nobody to fight over the cache line
+struct CounterBlock
+{
+	unsigned long long									calls[COUNTER_KINDS];
+	unsigned long long									merges[COUNTER_DEPTHS];
+	unsigned long long									tangent_steps[COUNTER_DEPTHS];
+	unsigned long long									merge_kills[COUNTER_DEPTHS];
+
+	// Recursion depth of whichever Triangulate call this thread is inside; -1 outside of one
+	int													depth;
+};
+
+//	--------------------------------------------------------
+//	The registry
+//	--------------------------------------------------------
+
+// Hangs on to every thread's block, even after the thread is gone, so the totals still add up at the end of a run
+// Reset and WriteJson don't synchronise with the counting itself, so only call them while nothing's triangulating
+class CounterRegistry
+{
+private:
+	std::mutex											lock_;
+	std::vector<std::unique_ptr<CounterBlock>>			blocks_;
+
+public:
+	CounterBlock*										Register();
+	void												Reset();
+	void												Totals(CounterBlock& out);
+	void												WriteJson(std::ostream& out);
+};
+
+CounterRegistry COUNTERS;
+
+CounterBlock* CounterRegistry::Register()
+{
+	std::lock_guard<std::mutex> guard(lock_);
+	blocks_.push_back(std::unique_ptr<CounterBlock>(new CounterBlock()));
+	blocks_.back()->depth = -1;
+	return blocks_.back().get();
+}
+
+void CounterRegistry::Reset()
+{
+	std::lock_guard<std::mutex> guard(lock_);
+	for (auto i = blocks_.begin(); i != blocks_.end(); i++)
+	{
+		int depth = (*i)->depth;
+		**i = CounterBlock();
+		(*i)->depth = depth;
+	}
+}
+
+void CounterRegistry::Totals(CounterBlock& out)
+{
+	std::lock_guard<std::mutex> guard(lock_);
+	out = CounterBlock();
+	out.depth = -1;
+	for (auto i = blocks_.begin(); i != blocks_.end(); i++)
+	{
+		for (int k = 0; k < COUNTER_KINDS; k++)
+		{
+			out.calls[k] += (*i)->calls[k];
+		}
+		for (int d = 0; d < COUNTER_DEPTHS; d++)
+		{
+			out.merges[d] += (*i)->merges[d];
+			out.tangent_steps[d] += (*i)->tangent_steps[d];
+			out.merge_kills[d] += (*i)->merge_kills[d];
+		}
+	}
+}
+
+void CounterRegistry::WriteJson(std::ostream& out)
+{
+	// One object: the call counts by name, then one entry per depth that saw any merges (depth 0 is the top-level merge)
+	CounterBlock totals;
+	Totals(totals);
+
+	out << "{";
+	for (int k = 0; k < COUNTER_KINDS; k++)
+	{
+		out << "\"" << COUNTER_NAMES[k] << "\":" << totals.calls[k] << ",";
+	}
+
+	out << "\"depths\":[";
+	bool first = true;
+	for (int d = 0; d < COUNTER_DEPTHS; d++)
+	{
+		if (totals.merges[d] == 0)
+		{
+			continue;
+		}
+		out << (first ? "" : ",") << "{\"depth\":" << d << ",\"merges\":" << totals.merges[d]
+			<< ",\"tangent_steps\":" << totals.tangent_steps[d] << ",\"kills\":" << totals.merge_kills[d] << "}";
+		first = false;
+	}
+	out << "]}";
+}
+
+//	--------------------------------------------------------
+//	Per-thread access
+//	--------------------------------------------------------
+
+CounterBlock& LocalCounters()
+{
+	thread_local CounterBlock* block = COUNTERS.Register();
+	return *block;
+}
+
+int CounterDepthBucket()
+{
+	int depth = LocalCounters().depth;
+	return (depth < 0) ? 0 : (depth < COUNTER_DEPTHS ? depth : COUNTER_DEPTHS - 1);
+}
+
+// Sets this thread's depth for as long as it's in scope, then puts the old one back
+// Join can run somebody else's task in the middle of ours, so the depth has to nest rather than just count up
+class CounterDepthScope
+{
+private:
+	int													saved_;
+
+public:
+	CounterDepthScope(int depth) : saved_(LocalCounters().depth)				{ LocalCounters().depth = depth; };
+	~CounterDepthScope()														{ LocalCounters().depth = saved_; };
+};
+
+//	--------------------------------------------------------
+//	The macros the hot paths actually use
+//	--------------------------------------------------------
+
+#define COUNT_CALL(kind)							(LocalCounters().calls[kind]++)
+
+// Triangulate opens a new level on entry; a forked half remembers its parent's level and restores it on whichever thread runs it
+#define COUNT_ENTER_LEVEL()							CounterDepthScope counter_level_(LocalCounters().depth + 1)
+#define COUNT_SAVE_LEVEL(name)						int name = LocalCounters().depth
+#define COUNT_RESTORE_LEVEL(name)					CounterDepthScope counter_restore_(name)
+
+#define COUNT_MERGE()								(LocalCounters().merges[CounterDepthBucket()]++)
+#define COUNT_TANGENT_STEP()						(LocalCounters().tangent_steps[CounterDepthBucket()]++)
+#define COUNT_MERGE_KILL()							(LocalCounters().merge_kills[CounterDepthBucket()]++)
+
+#else
+
+#define COUNT_CALL(kind)							((void)0)
+#define COUNT_ENTER_LEVEL()							((void)0)
+#define COUNT_SAVE_LEVEL(name)						((void)0)
+#define COUNT_RESTORE_LEVEL(name)					((void)0)
+#define COUNT_MERGE()								((void)0)
+#define COUNT_TANGENT_STEP()						((void)0)
+#define COUNT_MERGE_KILL()							((void)0)
+
+#endif
+
+//	--------------------------------------------------------
+
+#endif
@@ -14,8 +14,11 @@
 //	Include
 //	--------------------------------------------------------
 
-#include <SFML/Graphics.hpp>
+#include "arena.h"
+#include "coord.h"
+#include "counters.h"
 #include <memory>
+#include <vector>
 
 //	--------------------------------------------------------
 //	Forward declarations because C++
@@ -23,6 +26,7 @@
 
 class Edge;
 class QuadEdge;
+class EdgeStore;
 
 //	--------------------------------------------------------
 //	The Vert class
@@ -35,22 +39,32 @@ class Vert //: public sf::Vertex
 {
 private:
 	Edge*												edge_;
-	float												x_;
-	float												y_;
+	Coord												x_;
+	Coord												y_;
+	int													id_;
 public:
 	//Vert(float x, float y);
-	Vert(float x, float y);
+	Vert(Coord x, Coord y);
 
 	Edge*												edge()									{ return edge_; };
 	void												AddEdge(Edge* edge)						{ edge_ = edge; };
 
+	// Position in the sorted vertex list, so other structures can index by vertex; -1 for Voronoi vertices
+	int													id()									{ return id_; };
+	void												setId(int id)							{ id_ = id; };
+
 	//float												x()										{ return position.x; };
 	//float												y()										{ return position.y; };
 	//float												lengthsquared()							{ return position.x * position.x + position.y * position.y; };
 
-	int													x()										{ return x_; };
-	int													y()										{ return y_; };
-	int													lengthsquared()							{ return x_ * x_ + y_ * y_; };
+	// These used to hand back ints, which is fine for the pixel demo but mangles anything loaded from a file
+	// Now they hand back whatever Coord is (see coord.h), and the predicates pick their arithmetic to match
+	Coord												x()										{ return x_; };
+	Coord												y()										{ return y_; };
+	double												lengthsquared()							{ return (double)x_ * x_ + (double)y_ * y_; };
+
+	// Only for Delaunay::Move, which repairs the mesh afterwards; moving a Vert behind the triangulation's back breaks it
+	void												setPosition(Coord x, Coord y)			{ x_ = x; y_ = y; };
 	
 	//sf::Vector2f										getPosition()							{ return position; };
 };
@@ -66,7 +80,7 @@ Vert::Vert(float x, float y)
 }
 */
 
-Vert::Vert(float x, float y) : x_(x), y_(y)
+Vert::Vert(Coord x, Coord y) : edge_(nullptr), x_(x), y_(y), id_(-1)
 {
 
 }
@@ -119,18 +133,18 @@ public:
 	void setNext(Edge* next)							{ next_ = next; };
 	void setIndex(int index)							{ index_ = index; };
 	void setOrigin(Vert* org);
-	void setOrigin(sf::Vector2f org);
 	void setDestination(Vert* dest);
+	void clearOrigin()									{ origin_ = nullptr; draw = false; };
 
 	// Uses raw pointer because it's returning the array member of a QuadEdge
-	static Edge* Make(std::vector<QuadEdge*>& list);
+	static Edge* Make(EdgeStore& store);
 };
 
 //	--------------------------------------------------------
 //	Constructors and destructors
 //	--------------------------------------------------------
 
-Edge::Edge()
+Edge::Edge() : origin_(nullptr)
 {
 }
 
@@ -168,13 +182,6 @@ void Edge::setOrigin(Vert* origin)
 	draw = true;
 }
 
-void Edge::setOrigin(sf::Vector2f origin)
-{
-	origin_ = new Vert(origin.x, origin.y);
-	origin_->AddEdge(this);
-	draw = true;
-}
-
 void Edge::setDestination(Vert* dest)
 {
 	Edge* sym = Sym();
@@ -190,6 +197,7 @@ void Splice(Edge* a, Edge* b)
 {
 	// This remains unintelligible to me
 	// See Guibas and Stolfi, also Heckbert's code
+	COUNT_CALL(COUNT_SPLICE);
 
 	Edge* alpha = a->Onext()->Rot();
 	Edge* beta = b->Onext()->Rot();
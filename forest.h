@@ -0,0 +1,87 @@
+//	--------------------------------------------------------
+//	FOREST.H
+//	--------------------------------------------------------
+//	Contains a disjoint-set forest (union-find) over dense integer ids
+//	Union by size plus path halving, so any run of operations costs next to nothing per call
+//	--------------------------------------------------------
+
+#ifndef FOREST_H
+#define FOREST_H
+
+//	--------------------------------------------------------
+//	Include
+//	--------------------------------------------------------
+
+#include <utility>
+#include <vector>
+
+//	--------------------------------------------------------
+//	The class
+//	--------------------------------------------------------
+
+// Ids run from 0 to n - 1; Vert::id() is exactly that for the vertices of a triangulation
+class DisjointSets
+{
+private:
+	std::vector<int>									parent_;
+	std::vector<int>									size_;
+
+public:
+	DisjointSets(int n);
+
+	// The representative of i's set
+	int													Find(int i);
+
+	// Joins the sets holding a and b; false if they were already the same set
+	bool												Union(int a, int b);
+};
+
+//	--------------------------------------------------------
+//	Constructor
+//	--------------------------------------------------------
+
+DisjointSets::DisjointSets(int n) : parent_(n), size_(n, 1)
+{
+	for (int i = 0; i < n; i++)
+	{
+		parent_[i] = i;
+	}
+}
+
+//	--------------------------------------------------------
+//	Member functions
+//	--------------------------------------------------------
+
+int DisjointSets::Find(int i)
+{
+	// Point everything we pass at its grandparent on the way up, which roughly halves the path each time
+	while (parent_[i] != i)
+	{
+		parent_[i] = parent_[parent_[i]];
+		i = parent_[i];
+	}
+	return i;
+}
+
+bool DisjointSets::Union(int a, int b)
+{
+	a = Find(a);
+	b = Find(b);
+	if (a == b)
+	{
+		return false;
+	}
+
+	// Hang the smaller tree under the bigger one
+	if (size_[a] < size_[b])
+	{
+		std::swap(a, b);
+	}
+	parent_[b] = a;
+	size_[a] += size_[b];
+	return true;
+}
+
+//	--------------------------------------------------------
+
+#endif
@@ -0,0 +1,35 @@
+//	--------------------------------------------------------
+//	GRAPH.H
+//	--------------------------------------------------------
+//	Contains a compressed-sparse-row copy of the triangulation's vertex adjacency, for running ordinary graph algorithms on
+//	Vertex ids are the same dense ids the triangulation uses, so vertex i here is vertex i there
+//	--------------------------------------------------------
+
+#ifndef GRAPH_H
+#define GRAPH_H
+
+//	--------------------------------------------------------
+//	Include
+//	--------------------------------------------------------
+
+#include <vector>
+
+//	--------------------------------------------------------
+//	The struct
+//	--------------------------------------------------------
+
+// The neighbours of vertex v are neighbours[offsets[v]] up to neighbours[offsets[v + 1]], counterclockwise around v
+// lengths runs parallel to neighbours when it's asked for, and stays empty otherwise
+struct AdjacencyGraph
+{
+	std::vector<int>									offsets;
+	std::vector<int>									neighbours;
+	std::vector<float>									lengths;
+
+	int													VertexCount() const						{ return offsets.empty() ? 0 : (int)offsets.size() - 1; };
+	int													Degree(int v) const						{ return offsets[v + 1] - offsets[v]; };
+};
+
+//	--------------------------------------------------------
+
+#endif
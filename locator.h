@@ -0,0 +1,168 @@
+//	--------------------------------------------------------
+//	LOCATOR.H
+//	--------------------------------------------------------
+//	Contains a uniform grid over the vertices, used to pick a nearby starting point for walks through the mesh
+//	Jump to the grid cell, then walk; for reasonably spread-out points that's expected O(1) steps instead of O(sqrt n)
+//	--------------------------------------------------------
+
+#ifndef LOCATOR_H
+#define LOCATOR_H
+
+//	--------------------------------------------------------
+//	Include
+//	--------------------------------------------------------
+
+#include "edge.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//	--------------------------------------------------------
+//	The class
+//	--------------------------------------------------------
+
+// Every cell remembers the index of one vertex: one inside it if there is one, otherwise one from a nearby cell
+// It only ever hands out hints, so it's fine for it to go a little stale between rebuilds
+class PointLocator
+{
+private:
+	double												min_x_;
+	double												min_y_;
+	double												inv_width_;
+	double												inv_height_;
+	int													columns_;
+	int													rows_;
+	int													built_for_;
+	std::vector<int>									cells_;
+
+	int													Cell(double x, double y);
+
+public:
+	PointLocator();
+
+	// Bucket the vertices by position; vertex i is remembered as i
+	void												Build(const std::vector<Vert*>& verts);
+	void												Clear();
+
+	// Worth building again once the vertex count has doubled or halved since last time
+	bool												Stale(int vertex_count);
+
+	// The index of a vertex near (x, y), or -1 if there's nothing built
+	int													Seed(double x, double y);
+
+	// A new vertex at (x, y) becomes its cell's seed
+	void												Update(double x, double y, int index);
+};
+
+//	--------------------------------------------------------
+//	Constructor
+//	--------------------------------------------------------
+
+PointLocator::PointLocator() : min_x_(0), min_y_(0), inv_width_(0), inv_height_(0), columns_(0), rows_(0), built_for_(0)
+{
+}
+
+//	--------------------------------------------------------
+//	Member functions
+//	--------------------------------------------------------
+
+int PointLocator::Cell(double x, double y)
+{
+	// Anything off the edge of the grid goes in the nearest border cell
+	double cx = (x - min_x_) * inv_width_;
+	double cy = (y - min_y_) * inv_height_;
+	int column = (cx <= 0) ? 0 : (cx >= columns_ ? columns_ - 1 : (int)cx);
+	int row = (cy <= 0) ? 0 : (cy >= rows_ ? rows_ - 1 : (int)cy);
+	return row * columns_ + column;
+}
+
+void PointLocator::Build(const std::vector<Vert*>& verts)
+{
+	Clear();
+	built_for_ = verts.size();
+	if (verts.empty())
+	{
+		return;
+	}
+
+	double max_x = min_x_ = verts[0]->x();
+	double max_y = min_y_ = verts[0]->y();
+	for (auto i = verts.begin(); i != verts.end(); i++)
+	{
+		min_x_ = std::min(min_x_, (double)(*i)->x());
+		min_y_ = std::min(min_y_, (double)(*i)->y());
+		max_x = std::max(max_x, (double)(*i)->x());
+		max_y = std::max(max_y, (double)(*i)->y());
+	}
+
+	// About two vertices per cell, with the cells as square as the bounding box allows
+	double width = std::max(max_x - min_x_, 1e-30);
+	double height = std::max(max_y - min_y_, 1e-30);
+	double cells = std::max(1.0, verts.size() / 2.0);
+	double aspect = std::min(std::max(width / height, 1.0 / cells), cells);
+	columns_ = std::max(1, std::min((int)std::ceil(std::sqrt(cells * aspect)), (int)cells));
+	rows_ = std::max(1, std::min((int)std::ceil(cells / columns_), (int)cells));
+	inv_width_ = columns_ / width;
+	inv_height_ = rows_ / height;
+
+	cells_.assign(columns_ * rows_, -1);
+	for (int i = 0; i < verts.size(); i++)
+	{
+		cells_[Cell(verts[i]->x(), verts[i]->y())] = i;
+	}
+
+	// Then flood the empty cells outward from the full ones, so every cell has somebody close by
+	std::vector<int> frontier;
+	for (int c = 0; c < cells_.size(); c++)
+	{
+		if (cells_[c] >= 0)
+		{
+			frontier.push_back(c);
+		}
+	}
+	for (int k = 0; k < frontier.size(); k++)
+	{
+		int c = frontier[k];
+		int column = c % columns_;
+		int row = c / columns_;
+		int neighbours[4] = { column > 0 ? c - 1 : -1, column + 1 < columns_ ? c + 1 : -1, row > 0 ? c - columns_ : -1, row + 1 < rows_ ? c + columns_ : -1 };
+		for (int n = 0; n < 4; n++)
+		{
+			if (neighbours[n] >= 0 && cells_[neighbours[n]] < 0)
+			{
+				cells_[neighbours[n]] = cells_[c];
+				frontier.push_back(neighbours[n]);
+			}
+		}
+	}
+}
+
+void PointLocator::Clear()
+{
+	cells_.clear();
+	columns_ = 0;
+	rows_ = 0;
+	built_for_ = 0;
+}
+
+bool PointLocator::Stale(int vertex_count)
+{
+	return cells_.empty() || vertex_count > 2 * built_for_ || 2 * vertex_count < built_for_;
+}
+
+int PointLocator::Seed(double x, double y)
+{
+	return cells_.empty() ? -1 : cells_[Cell(x, y)];
+}
+
+void PointLocator::Update(double x, double y, int index)
+{
+	if (!cells_.empty())
+	{
+		cells_[Cell(x, y)] = index;
+	}
+}
+
+//	--------------------------------------------------------
+
+#endif
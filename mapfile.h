@@ -0,0 +1,211 @@
+//	--------------------------------------------------------
+//	MAPFILE.H
+//	--------------------------------------------------------
+//	Contains a read-only memory-mapped file, so big inputs can be used in place instead of read into a buffer
+//	Uses mmap on POSIX systems and file mappings on Windows
+//	--------------------------------------------------------
+
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+//	--------------------------------------------------------
+//	Include
+//	--------------------------------------------------------
+
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//	--------------------------------------------------------
+//	The class
+//	--------------------------------------------------------
+
+class MappedFile
+{
+private:
+	const char*											data_;
+	size_t												size_;
+
+#ifdef _WIN32
+	HANDLE												file_;
+	HANDLE												mapping_;
+#else
+	int													file_;
+#endif
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Returns false if the file can't be opened or mapped; an empty file opens fine with a null data pointer
+	bool												Open(const char* path);
+	void												Close();
+
+	const char*											data()									{ return data_; };
+	size_t												size()									{ return size_; };
+};
+
+//	--------------------------------------------------------
+//	Constructors and destructors
+//	--------------------------------------------------------
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : data_(nullptr), size_(0), file_(INVALID_HANDLE_VALUE), mapping_(nullptr)
+{
+}
+
+#else
+
+MappedFile::MappedFile() : data_(nullptr), size_(0), file_(-1)
+{
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+//	--------------------------------------------------------
+//	Member functions
+//	--------------------------------------------------------
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const char* path)
+{
+	Close();
+
+	file_ = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file_ == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file_, &size))
+	{
+		Close();
+		return false;
+	}
+	size_ = size.QuadPart;
+
+	// Windows won't map an empty file, and there's nothing to read anyway
+	if (size_ == 0)
+	{
+		return true;
+	}
+
+	mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_ == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	data_ = (const char*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+	if (data_ == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data_ != nullptr)
+	{
+		UnmapViewOfFile(data_);
+	}
+	if (mapping_ != nullptr)
+	{
+		CloseHandle(mapping_);
+	}
+	if (file_ != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(file_);
+	}
+
+	data_ = nullptr;
+	size_ = 0;
+	mapping_ = nullptr;
+	file_ = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::Open(const char* path)
+{
+	Close();
+
+	file_ = open(path, O_RDONLY);
+	if (file_ < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file_, &info) != 0)
+	{
+		Close();
+		return false;
+	}
+	size_ = info.st_size;
+
+	// mmap refuses zero-length mappings, and there's nothing to read anyway
+	if (size_ == 0)
+	{
+		return true;
+	}
+
+	void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file_, 0);
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	// We read it front to back, so let the kernel read ahead
+	madvise(data, size_, MADV_SEQUENTIAL);
+	data_ = (const char*)data;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data_ != nullptr)
+	{
+		munmap((void*)data_, size_);
+	}
+	if (file_ >= 0)
+	{
+		close(file_);
+	}
+
+	data_ = nullptr;
+	size_ = 0;
+	file_ = -1;
+}
+
+#endif
+
+//	--------------------------------------------------------
+
+#endif
@@ -0,0 +1,248 @@
+//	--------------------------------------------------------
+//	MESH.H
+//	--------------------------------------------------------
+//	Contains a compact, index-based take on the quad-edge structure
+//	Edges and vertices are 32-bit indices instead of pointers, and vertex coordinates sit in flat x[]/y[] arrays
+//	Same algebra as edge.h and quadedge.h; see Guibas and Stolfi (1985)
+//	--------------------------------------------------------
+
+#ifndef MESH_H
+#define MESH_H
+
+//	--------------------------------------------------------
+//	Include
+//	--------------------------------------------------------
+
+#include "quadedge.h"
+#include <cstdint>
+#include <vector>
+
+//	--------------------------------------------------------
+//	Some typedefs for readability
+//	--------------------------------------------------------
+
+// An edge is its quad's index shifted up two bits, with the rotation (0-3) in the low bits
+// So Rot, InvRot and Sym are just bit twiddling, and the quad's four Onext slots sit side by side
+typedef uint32_t									EdgeRef;
+typedef uint32_t									VertRef;
+
+const VertRef NO_VERT = 0xFFFFFFFF;
+const VertRef DEAD_QUAD = 0xFFFFFFFE;
+
+//	--------------------------------------------------------
+//	The class
+//	--------------------------------------------------------
+
+// 16 bytes of Onext plus 8 bytes of origins per quad edge, against 152 for a pooled QuadEdge plus its list entry (on 64-bit)
+// Only the primal edges (rotations 0 and 2) get an origin; the dual ones just keep their Onext rings
+class CompactMesh
+{
+private:
+	std::vector<EdgeRef>								next_;
+	std::vector<VertRef>								origin_;
+	std::vector<uint32_t>								free_;
+
+	VertRef&											OriginSlot(EdgeRef e)					{ return origin_[(e >> 2) * 2 + ((e >> 1) & 1)]; };
+
+public:
+	// Vertex data, structure-of-arrays
+	std::vector<Coord>									x;
+	std::vector<Coord>									y;
+	std::vector<EdgeRef>								vert_edge;
+
+	// The four primitive algebraic operations; see Guibas and Stolfi
+
+	static EdgeRef										Rot(EdgeRef e)							{ return (e & ~3u) | ((e + 1) & 3u); };
+	static EdgeRef										InvRot(EdgeRef e)						{ return (e & ~3u) | ((e + 3) & 3u); };
+	static EdgeRef										Sym(EdgeRef e)							{ return e ^ 2u; };
+	EdgeRef												Onext(EdgeRef e)						{ return next_[e]; };
+
+	// These guys can be derived from the four primitive operations
+
+	EdgeRef												Oprev(EdgeRef e)						{ return Rot(Onext(Rot(e))); };
+	EdgeRef												Dnext(EdgeRef e)						{ return Sym(Onext(Sym(e))); };
+	EdgeRef												Dprev(EdgeRef e)						{ return InvRot(Onext(InvRot(e))); };
+	EdgeRef												Lnext(EdgeRef e)						{ return Rot(Onext(InvRot(e))); };
+	EdgeRef												Lprev(EdgeRef e)						{ return Sym(Onext(e)); };
+	EdgeRef												Rnext(EdgeRef e)						{ return InvRot(Onext(Rot(e))); };
+	EdgeRef												Rprev(EdgeRef e)						{ return Onext(Sym(e)); };
+
+	// Accessors and mutators
+
+	VertRef												Origin(EdgeRef e)						{ return OriginSlot(e); };
+	VertRef												Destination(EdgeRef e)					{ return OriginSlot(Sym(e)); };
+	void												SetOrigin(EdgeRef e, VertRef v);
+	void												SetDestination(EdgeRef e, VertRef v);
+
+	int													QuadCount()								{ return next_.size() / 4; };
+	bool												Alive(uint32_t quad)					{ return origin_[quad * 2] != DEAD_QUAD; };
+	size_t												Bytes();
+
+	// Building and tearing down
+
+	VertRef												AddVert(Coord vx, Coord vy);
+	EdgeRef												MakeEdge();
+	void												Splice(EdgeRef a, EdgeRef b);
+	EdgeRef												Connect(EdgeRef a, EdgeRef b);
+	void												DeleteEdge(EdgeRef e);
+	void												Clear();
+
+	// Copy the primal mesh out of the pointer-based structure; quad i here is quads[i] there and verts[i] (whose id() is i) is vertex i
+	void												Assign(const std::vector<Vert*>& verts, const std::vector<QuadEdge*>& quads);
+};
+
+//	--------------------------------------------------------
+//	Member functions
+//	--------------------------------------------------------
+
+void CompactMesh::SetOrigin(EdgeRef e, VertRef v)
+{
+	OriginSlot(e) = v;
+	vert_edge[v] = e;
+}
+
+void CompactMesh::SetDestination(EdgeRef e, VertRef v)
+{
+	SetOrigin(Sym(e), v);
+}
+
+size_t CompactMesh::Bytes()
+{
+	return next_.capacity() * sizeof(EdgeRef) + origin_.capacity() * sizeof(VertRef) + free_.capacity() * sizeof(uint32_t)
+		+ (x.capacity() + y.capacity()) * sizeof(Coord) + vert_edge.capacity() * sizeof(EdgeRef);
+}
+
+VertRef CompactMesh::AddVert(Coord vx, Coord vy)
+{
+	x.push_back(vx);
+	y.push_back(vy);
+	vert_edge.push_back(NO_VERT);
+	return x.size() - 1;
+}
+
+EdgeRef CompactMesh::MakeEdge()
+{
+	// Reuse a dead quad if there is one
+	uint32_t quad;
+	if (!free_.empty())
+	{
+		quad = free_.back();
+		free_.pop_back();
+	}
+	else
+	{
+		quad = QuadCount();
+		next_.resize(next_.size() + 4);
+		origin_.resize(origin_.size() + 2);
+	}
+
+	// Same starting rings as the QuadEdge constructor
+	EdgeRef e = quad << 2;
+	next_[e + 0] = e + 0;
+	next_[e + 1] = e + 3;
+	next_[e + 2] = e + 2;
+	next_[e + 3] = e + 1;
+	origin_[quad * 2 + 0] = NO_VERT;
+	origin_[quad * 2 + 1] = NO_VERT;
+
+	return e;
+}
+
+void CompactMesh::Splice(EdgeRef a, EdgeRef b)
+{
+	// Same as Splice in edge.h
+	EdgeRef alpha = Rot(Onext(a));
+	EdgeRef beta = Rot(Onext(b));
+
+	EdgeRef t1 = Onext(b);
+	EdgeRef t2 = Onext(a);
+	EdgeRef t3 = Onext(beta);
+	EdgeRef t4 = Onext(alpha);
+
+	next_[a] = t1;
+	next_[b] = t2;
+	next_[alpha] = t3;
+	next_[beta] = t4;
+}
+
+EdgeRef CompactMesh::Connect(EdgeRef a, EdgeRef b)
+{
+	// Same as Delaunay::Connect
+	EdgeRef e = MakeEdge();
+	SetOrigin(e, Destination(a));
+	SetDestination(e, Origin(b));
+	Splice(e, Lnext(a));
+	Splice(Sym(e), b);
+	return e;
+}
+
+void CompactMesh::DeleteEdge(EdgeRef e)
+{
+	// Same as Delaunay::Kill, including not leaving the endpoints pointing at a recycled edge
+	EdgeRef sym = Sym(e);
+	VertRef org = Origin(e);
+	VertRef dest = Origin(sym);
+	if (org != NO_VERT && vert_edge[org] == e)
+	{
+		vert_edge[org] = (Onext(e) != e) ? Onext(e) : NO_VERT;
+	}
+	if (dest != NO_VERT && vert_edge[dest] == sym)
+	{
+		vert_edge[dest] = (Onext(sym) != sym) ? Onext(sym) : NO_VERT;
+	}
+
+	Splice(e, Oprev(e));
+	Splice(sym, Oprev(sym));
+
+	uint32_t quad = e >> 2;
+	origin_[quad * 2 + 0] = DEAD_QUAD;
+	origin_[quad * 2 + 1] = DEAD_QUAD;
+	free_.push_back(quad);
+}
+
+void CompactMesh::Clear()
+{
+	next_.clear();
+	origin_.clear();
+	free_.clear();
+	x.clear();
+	y.clear();
+	vert_edge.clear();
+}
+
+void CompactMesh::Assign(const std::vector<Vert*>& verts, const std::vector<QuadEdge*>& quads)
+{
+	Clear();
+
+	// Ids are dense like slots, so vertex i there goes in at i here and its id doubles as the VertRef
+	for (auto i = verts.begin(); i != verts.end(); i++)
+	{
+		AddVert((*i)->x(), (*i)->y());
+	}
+
+	next_.resize(4 * quads.size());
+	origin_.resize(2 * quads.size());
+
+	for (int q = 0; q < quads.size(); q++)
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			// Slots are dense, so a QuadEdge's slot doubles as its index here
+			Edge* next = quads[q]->edges[r].Onext();
+			QuadEdge* owner = (QuadEdge*)(next - next->index());
+			next_[4 * q + r] = (owner->slot << 2) | next->index();
+		}
+
+		for (int r = 0; r < 4; r += 2)
+		{
+			Vert* org = quads[q]->edges[r].origin();
+			VertRef v = org->id();
+			origin_[2 * q + r / 2] = v;
+			vert_edge[v] = (q << 2) | r;
+		}
+	}
+}
+
+//	--------------------------------------------------------
+
+#endif
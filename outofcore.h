@@ -0,0 +1,576 @@
+//	--------------------------------------------------------
+//	OUTOFCORE.H
+//	--------------------------------------------------------
+//	Contains a triangulation mode for point files too big to hold in memory at once
+//	The points get sorted externally, then triangulated a vertical strip at a time, and every triangle goes out to disk
+//	as soon as no point still to come could land in its circumcircle; only the ragged boundary between done and not done stays resident
+//	--------------------------------------------------------
+//
+//	Input file: the same packed (x, y) float records as TriangulateFile
+//	Output file: the same as TriangulateFile asking for triangles: a uint64 triangle count, then (uint32, uint32, uint32) record indices
+//	Triangles come out in sweep order rather than the order GetTriangles would give, but it's the same set of them
+//
+//	--------------------------------------------------------
+
+#ifndef OUTOFCORE_H
+#define OUTOFCORE_H
+
+//	--------------------------------------------------------
+//	Include
+//	--------------------------------------------------------
+
+#include "batch.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+//	--------------------------------------------------------
+//	Budget
+//	--------------------------------------------------------
+
+// Rough peak bytes per point while a strip is being triangulated: the Vert and its share of the QuadEdges, the triangle list,
+// the copies made along the way and the bookkeeping for whatever stays resident
+const size_t STRIP_BYTES_PER_POINT = 640;
+
+// And while a run is being sorted: the records going in, the keys and indices, and the radix sort's buffers
+const size_t SORT_BYTES_PER_POINT = 64;
+
+// However much of the budget the resident boundary eats, every strip gets at least this many new points
+const size_t MIN_STRIP_POINTS = 4096;
+
+// Any less and not even the smallest strip fits, so TriangulateFileOutOfCore turns the budget down rather than quietly going over it
+const size_t MIN_MEMORY_BUDGET = 2 * MIN_STRIP_POINTS * STRIP_BYTES_PER_POINT;
+
+//	--------------------------------------------------------
+//	Sorted runs
+//	--------------------------------------------------------
+
+// One point on its way through the external sort
+struct StreamRecord
+{
+	uint64_t											key;
+	float												x;
+	float												y;
+	uint32_t											index;
+};
+
+// Reads a sorted run back a buffer at a time
+class RunReader
+{
+private:
+	FILE*												file_;
+	std::vector<StreamRecord>							buffer_;
+	size_t												next_;
+	size_t												filled_;
+
+public:
+	RunReader(FILE* file, size_t buffer_records) : file_(file), buffer_(buffer_records), next_(0), filled_(0)		{ };
+	~RunReader()																{ fclose(file_); };
+
+	RunReader(const RunReader&) = delete;
+	RunReader& operator=(const RunReader&) = delete;
+
+	// The next record, or nullptr once the run is used up
+	const StreamRecord*									Peek();
+	void												Pop()									{ next_++; };
+};
+
+const StreamRecord* RunReader::Peek()
+{
+	if (next_ == filled_)
+	{
+		filled_ = fread(buffer_.data(), sizeof(StreamRecord), buffer_.size(), file_);
+		next_ = 0;
+	}
+	return (next_ < filled_) ? &buffer_[next_] : nullptr;
+}
+
+// Merges any number of sorted runs into one sorted stream of distinct points
+// Equal keys come out of lower-numbered runs first, and runs are numbered in input order, so a duplicate always maps to its first record
+class SortedStream
+{
+private:
+	typedef std::pair<uint64_t, int>					HeapEntry;
+
+	std::vector<std::unique_ptr<RunReader>>				runs_;
+	std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>>	heap_;
+	bool												started_;
+	bool												any_;
+	uint64_t											last_key_;
+
+	void												Advance(int run);
+	void												SkipDuplicates();
+
+public:
+	SortedStream() : started_(false), any_(false), last_key_(0)				{ };
+
+	void												Add(FILE* run, size_t buffer_records);
+
+	// The next distinct point, without taking it; nullptr at the end
+	const StreamRecord*									Peek();
+	bool												Next(StreamRecord& out);
+};
+
+void SortedStream::Add(FILE* run, size_t buffer_records)
+{
+	runs_.push_back(std::unique_ptr<RunReader>(new RunReader(run, buffer_records)));
+}
+
+void SortedStream::Advance(int run)
+{
+	const StreamRecord* record = runs_[run]->Peek();
+	if (record != nullptr)
+	{
+		heap_.push(HeapEntry(record->key, run));
+	}
+}
+
+void SortedStream::SkipDuplicates()
+{
+	if (!started_)
+	{
+		for (int r = 0; r < runs_.size(); r++)
+		{
+			Advance(r);
+		}
+		started_ = true;
+	}
+
+	while (any_ && !heap_.empty() && heap_.top().first == last_key_)
+	{
+		int run = heap_.top().second;
+		heap_.pop();
+		runs_[run]->Pop();
+		Advance(run);
+	}
+}
+
+const StreamRecord* SortedStream::Peek()
+{
+	SkipDuplicates();
+	return heap_.empty() ? nullptr : runs_[heap_.top().second]->Peek();
+}
+
+bool SortedStream::Next(StreamRecord& out)
+{
+	const StreamRecord* record = Peek();
+	if (record == nullptr)
+	{
+		return false;
+	}
+
+	out = *record;
+	last_key_ = out.key;
+	any_ = true;
+
+	int run = heap_.top().second;
+	heap_.pop();
+	runs_[run]->Pop();
+	Advance(run);
+	return true;
+}
+
+// Sorts the input a budget-sized chunk at a time into anonymous temporary files, and hands them to stream
+bool SortIntoRuns(const float* xy, uint64_t count, size_t run_points, size_t buffer_records, SortedStream& stream)
+{
+	std::vector<uint64_t> keys;
+	std::vector<uint32_t> order;
+	std::vector<StreamRecord> records;
+
+	for (uint64_t base = 0; base < count; base += run_points)
+	{
+		int n = (int)std::min<uint64_t>(run_points, count - base);
+		SortPoints(xy + 2 * base, n, keys, order);
+
+		records.resize(keys.size());
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			uint64_t record = base + order[i];
+			records[i].key = keys[i];
+			records[i].x = xy[2 * record];
+			records[i].y = xy[2 * record + 1];
+			records[i].index = (uint32_t)record;
+		}
+
+		FILE* run = tmpfile();
+		if (run == nullptr)
+		{
+			return false;
+		}
+		stream.Add(run, buffer_records);
+		if ((!records.empty() && fwrite(records.data(), sizeof(StreamRecord), records.size(), run) != records.size()) || fseek(run, 0, SEEK_SET) != 0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//	--------------------------------------------------------
+//	Triangles still waiting on the sweep
+//	--------------------------------------------------------
+
+// A triangle by its corners' record indices, smallest first, so it's the same key whichever corner a triangulation starts from
+struct TriangleKey
+{
+	uint32_t											corner[3];
+
+	bool operator==(const TriangleKey& other) const
+	{
+		return corner[0] == other.corner[0] && corner[1] == other.corner[1] && corner[2] == other.corner[2];
+	}
+};
+
+struct TriangleKeyHash
+{
+	size_t operator()(const TriangleKey& key) const
+	{
+		uint64_t h = key.corner[0];
+		h = h * 0x9E3779B97F4A7C15ull + key.corner[1];
+		h = h * 0x9E3779B97F4A7C15ull + key.corner[2];
+		return (size_t)(h ^ (h >> 29));
+	}
+};
+
+TriangleKey MakeTriangleKey(uint32_t a, uint32_t b, uint32_t c)
+{
+	TriangleKey key;
+	key.corner[0] = std::min(a, std::min(b, c));
+	key.corner[2] = std::max(a, std::max(b, c));
+	key.corner[1] = a ^ b ^ c ^ key.corner[0] ^ key.corner[2];
+	return key;
+}
+
+// Corner coordinates, counterclockwise
+struct TriangleCorners
+{
+	double												x[3];
+	double												y[3];
+};
+
+typedef std::unordered_map<TriangleKey, TriangleCorners, TriangleKeyHash>	PendingTriangles;
+
+// The pending triangles that a retriangulation didn't reproduce, bucketed by height so "is this point in one of them" is cheap
+// That only happens with co-circular points, where the resident points alone can pick the other diagonal
+class TriangleCover
+{
+private:
+	std::vector<TriangleCorners>						triangles_;
+	std::vector<std::vector<int>>						bins_;
+	double												min_y_;
+	double												inv_height_;
+
+	int													Bin(double y);
+
+public:
+	TriangleCover(const std::vector<TriangleCorners>& triangles);
+
+	bool												Contains(double x, double y);
+};
+
+TriangleCover::TriangleCover(const std::vector<TriangleCorners>& triangles) : triangles_(triangles), min_y_(0), inv_height_(0)
+{
+	if (triangles_.empty())
+	{
+		return;
+	}
+
+	double max_y = min_y_ = triangles_[0].y[0];
+	for (auto t = triangles_.begin(); t != triangles_.end(); t++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			min_y_ = std::min(min_y_, t->y[k]);
+			max_y = std::max(max_y, t->y[k]);
+		}
+	}
+
+	bins_.resize(triangles_.size());
+	inv_height_ = bins_.size() / std::max(max_y - min_y_, 1e-30);
+	for (int i = 0; i < triangles_.size(); i++)
+	{
+		const TriangleCorners& t = triangles_[i];
+		int low = Bin(std::min(t.y[0], std::min(t.y[1], t.y[2])));
+		int high = Bin(std::max(t.y[0], std::max(t.y[1], t.y[2])));
+		for (int b = low; b <= high; b++)
+		{
+			bins_[b].push_back(i);
+		}
+	}
+}
+
+int TriangleCover::Bin(double y)
+{
+	double b = (y - min_y_) * inv_height_;
+	return (b <= 0) ? 0 : (b >= bins_.size() ? (int)bins_.size() - 1 : (int)b);
+}
+
+bool TriangleCover::Contains(double x, double y)
+{
+	if (triangles_.empty())
+	{
+		return false;
+	}
+
+	const std::vector<int>& bin = bins_[Bin(y)];
+	for (auto i = bin.begin(); i != bin.end(); i++)
+	{
+		const TriangleCorners& t = triangles_[*i];
+		bool inside = true;
+		for (int k = 0; k < 3 && inside; k++)
+		{
+			int j = (k + 1) % 3;
+			inside = (t.x[j] - t.x[k]) * (y - t.y[k]) - (t.y[j] - t.y[k]) * (x - t.x[k]) >= 0;
+		}
+		if (inside)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//	--------------------------------------------------------
+//	The entry point
+//	--------------------------------------------------------
+
+// Wall-clock milliseconds, plus how the sweep went
+struct OutOfCoreStats
+{
+	double												sort_ms;
+	double												triangulate_ms;
+	long long											strips;
+	long long											max_resident;
+	uint64_t											triangles;
+};
+
+// Like TriangulateFile asking for triangles, but never holds much more than memory_budget bytes of points and mesh at once
+// Returns false (and says why on std::cerr) if either file can't be used or the budget is under MIN_MEMORY_BUDGET
+//
+// How the sweep stays exact: every step triangulates the resident points plus the next strip from scratch, as one fresh Delaunay.
+// Nothing gets stitched onto last step's mesh; the recursion splits at its own medians, not at the seam between the two. That's on
+// purpose, since merging onto the old mesh would mean keeping it live and taking every dropped point out of it one by one. What it
+// costs is re-sorting and re-triangulating the resident band every step: O((r + s) log(r + s)) for r resident and s new points, so
+// the sweep does about (r + s) / s times the work of an in-memory run, which stays small as long as the band is thin next to the strip.
+// A triangle whose circumcircle ends left of the next unread point is final, since nothing still to come
+// can get inside it. A point is dropped once it's off the convex hull and every triangle round it is final, which means its star
+// can never change again. The only triangles the smaller point set makes that the full one wouldn't are the ones papering over
+// the dropped points, and those have nothing but resident corners and weren't pending last time, so they're easy to spot
+bool TriangulateFileOutOfCore(const char* input_path, const char* output_path, size_t memory_budget, int threads, OutOfCoreStats& stats)
+{
+	stats = OutOfCoreStats();
+	if (memory_budget < MIN_MEMORY_BUDGET)
+	{
+		std::cerr << "A memory budget of " << memory_budget << " bytes is too small to sweep in; it needs at least "
+			<< ((MIN_MEMORY_BUDGET + (1 << 20) - 1) >> 20) << " MB" << std::endl;
+		return false;
+	}
+
+	// Map the input; it only gets read front to back, once, so the pages can go again as soon as they've been sorted
+	auto start = std::chrono::high_resolution_clock::now();
+	MappedFile input;
+	if (!input.Open(input_path))
+	{
+		std::cerr << "Couldn't map " << input_path << std::endl;
+		return false;
+	}
+	if (input.size() % (2 * sizeof(float)) != 0)
+	{
+		std::cerr << input_path << " isn't a whole number of (x, y) float records" << std::endl;
+		return false;
+	}
+	uint64_t count = input.size() / (2 * sizeof(float));
+	if (count > 0xFFFFFFFFull)
+	{
+		std::cerr << input_path << " has more records than 32-bit indices can name" << std::endl;
+		return false;
+	}
+
+	size_t strip_points = memory_budget / STRIP_BYTES_PER_POINT;
+	size_t run_points = std::min<size_t>(std::max(memory_budget / SORT_BYTES_PER_POINT, MIN_STRIP_POINTS), 0x7FFFFFFF);
+	size_t runs = std::max<size_t>(1, (count + run_points - 1) / run_points);
+	size_t buffer_records = std::max<size_t>(256, std::min<size_t>(1 << 16, memory_budget / (8 * sizeof(StreamRecord) * runs)));
+
+	SortedStream stream;
+	if (!SortIntoRuns((const float*)input.data(), count, run_points, buffer_records, stream))
+	{
+		std::cerr << "Couldn't write the sorted runs to temporary files" << std::endl;
+		return false;
+	}
+	input.Close();
+	stats.sort_ms = MillisecondsSince(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	FILE* output = fopen(output_path, "wb");
+	if (output == nullptr)
+	{
+		std::cerr << "Couldn't open " << output_path << " for writing" << std::endl;
+		return false;
+	}
+
+	// The count isn't known until the end, so it gets filled in then
+	uint64_t triangle_count = 0;
+	bool ok = fwrite(&triangle_count, sizeof(triangle_count), 1, output) == 1;
+	ChunkWriter writer(output);
+
+	// Resident points first, then the strip, all in sorted order; anything pending is keyed by record index
+	std::vector<StreamRecord> points;
+	PendingTriangles pending;
+	std::vector<float> xy;
+	std::vector<int> corners;
+
+	while (ok && stream.Peek() != nullptr)
+	{
+		size_t resident = points.size();
+		size_t strip = (strip_points > resident + MIN_STRIP_POINTS) ? strip_points - resident : MIN_STRIP_POINTS;
+		StreamRecord record;
+		for (size_t i = 0; i < strip && stream.Next(record); i++)
+		{
+			points.push_back(record);
+		}
+
+		// Every point still to come is at least this far right
+		const StreamRecord* next = stream.Peek();
+		bool last = (next == nullptr);
+		double frontier = last ? 0 : next->x;
+
+		xy.resize(2 * points.size());
+		for (size_t i = 0; i < points.size(); i++)
+		{
+			xy[2 * i] = points[i].x;
+			xy[2 * i + 1] = points[i].y;
+		}
+
+		// Resident and strip together, from scratch; see above for why this isn't a merge onto last step's mesh
+		Delaunay del(xy.data(), points.size());
+		del.GetTriangulation(threads);
+		del.GetTriangles(corners, threads);
+		const std::vector<int>& sources = del.GetSources();
+
+		// First, which pending triangles came back; any that didn't, co-circular points re-diagonalised, and whatever covers them now is still ours
+		PendingTriangles present;
+		for (size_t t = 0; t < corners.size(); t += 3)
+		{
+			int a = sources[corners[t]], b = sources[corners[t + 1]], c = sources[corners[t + 2]];
+			if (a < resident && b < resident && c < resident)
+			{
+				TriangleKey key = MakeTriangleKey(points[a].index, points[b].index, points[c].index);
+				auto found = pending.find(key);
+				if (found != pending.end())
+				{
+					present.insert(*found);
+				}
+			}
+		}
+
+		std::vector<TriangleCorners> missing;
+		if (present.size() < pending.size())
+		{
+			for (auto i = pending.begin(); i != pending.end(); i++)
+			{
+				if (present.find(i->first) == present.end())
+				{
+					missing.push_back(i->second);
+				}
+			}
+		}
+		TriangleCover rediagonalised(missing);
+
+		// Then sort every triangle into papering-over (skip), final (write it out) or pending (keep it and its corners around)
+		PendingTriangles still_pending;
+		std::vector<char> keep(points.size(), 0);
+		for (size_t t = 0; t < corners.size(); t += 3)
+		{
+			int p[3] = { sources[corners[t]], sources[corners[t + 1]], sources[corners[t + 2]] };
+			TriangleKey key = MakeTriangleKey(points[p[0]].index, points[p[1]].index, points[p[2]].index);
+
+			TriangleCorners at;
+			for (int k = 0; k < 3; k++)
+			{
+				at.x[k] = points[p[k]].x;
+				at.y[k] = points[p[k]].y;
+			}
+
+			bool fresh = p[0] >= resident || p[1] >= resident || p[2] >= resident;
+			if (!fresh && present.find(key) == present.end()
+				&& !rediagonalised.Contains((at.x[0] + at.x[1] + at.x[2]) / 3, (at.y[0] + at.y[1] + at.y[2]) / 3))
+			{
+				continue;
+			}
+
+			// Final if the circumcircle ends strictly left of the frontier, with a little slack for rounding in the center
+			double cx, cy;
+			Circumcenter(at.x[0], at.y[0], at.x[1], at.y[1], at.x[2], at.y[2], cx, cy);
+			double r = std::sqrt((at.x[0] - cx) * (at.x[0] - cx) + (at.y[0] - cy) * (at.y[0] - cy));
+			if (last || cx + r < frontier - 1e-9 * (std::fabs(cx) + r + std::fabs(frontier)))
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					writer.Put(points[p[k]].index);
+				}
+				triangle_count++;
+			}
+			else
+			{
+				still_pending[key] = at;
+				keep[p[0]] = keep[p[1]] = keep[p[2]] = 1;
+			}
+		}
+
+		// Hull points stay too, since whatever comes next can still attach to them from outside
+		const QuadList& quads = del.GetQuads();
+		for (auto q = quads.begin(); q != quads.end(); q++)
+		{
+			Edge* e = (*q)->edges;
+			if (!Delaunay::IsTriangle(e) || !Delaunay::IsTriangle(e->Sym()))
+			{
+				keep[sources[e->origin()->id()]] = 1;
+				keep[sources[e->destination()->id()]] = 1;
+			}
+		}
+
+		// Still collinear, so there's no hull to speak of yet; hang on to everything
+		if (corners.empty())
+		{
+			std::fill(keep.begin(), keep.end(), 1);
+		}
+
+		size_t kept = 0;
+		for (size_t i = 0; i < points.size(); i++)
+		{
+			if (keep[i])
+			{
+				points[kept++] = points[i];
+			}
+		}
+		points.resize(kept);
+		pending.swap(still_pending);
+
+		stats.strips++;
+		stats.max_resident = std::max(stats.max_resident, (long long)kept);
+		ok = writer.ok();
+	}
+
+	writer.Flush();
+	ok = ok && writer.ok();
+	ok = ok && fseek(output, 0, SEEK_SET) == 0 && fwrite(&triangle_count, sizeof(triangle_count), 1, output) == 1;
+	ok = (fclose(output) == 0) && ok;
+	stats.triangles = triangle_count;
+	stats.triangulate_ms = MillisecondsSince(start);
+
+	if (!ok)
+	{
+		std::cerr << "Couldn't finish writing " << output_path << std::endl;
+	}
+	return ok;
+}
+
+//	--------------------------------------------------------
+
+#endif
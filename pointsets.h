@@ -0,0 +1,233 @@
+//	--------------------------------------------------------
+//	POINTSETS.H
+//	--------------------------------------------------------
+//	Contains the batch API for triangulating lots of small, independent point sets (one per map tile, one per frame, ...)
+//	Every worker thread keeps one Delaunay object and retriangulates it for set after set, so nothing gets freed in between
+//	--------------------------------------------------------
+
+#ifndef POINTSETS_H
+#define POINTSETS_H
+
+//	--------------------------------------------------------
+//	Include
+//	--------------------------------------------------------
+
+#include "tasks.h"
+#include "topology.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+//	--------------------------------------------------------
+//	Input and output
+//	--------------------------------------------------------
+
+// Many point sets packed end to end: set s is the (x, y) records [offsets[s], offsets[s + 1]) of xy
+struct PointSets
+{
+	std::vector<Coord>									xy;
+	std::vector<int>									offsets;
+
+	PointSets() : offsets(1, 0)																	{ };
+
+	int													SetCount() const						{ return (int)offsets.size() - 1; };
+	int													Size(int s) const						{ return offsets[s + 1] - offsets[s]; };
+	const Coord*										Records(int s) const					{ return xy.data() + 2 * (size_t)offsets[s]; };
+
+	void												Add(const Coord* records, int count);
+	void												Clear();
+};
+
+// The triangles of every set in one buffer: set s has triangles [first_triangle[s], first_triangle[s + 1])
+// Each is three counterclockwise corners, as indices into that set's own records; duplicates map to their first record
+struct TriangleSets
+{
+	std::vector<int>									first_triangle;
+	std::vector<int>									indices;
+
+	int													TriangleCount(int s) const				{ return first_triangle[s + 1] - first_triangle[s]; };
+	const int*											Triangles(int s) const					{ return indices.data() + 3 * (size_t)first_triangle[s]; };
+};
+
+//	--------------------------------------------------------
+//	The workspace
+//	--------------------------------------------------------
+
+// Everything one worker needs, kept between sets: the triangulation with its pools, and somewhere to put the results
+// Results pile up here in the order the worker got to them, and get copied into place once everybody's done
+class TriangulationWorkspace
+{
+private:
+	Delaunay											delaunay_;
+	std::vector<int>									triangles_;
+
+public:
+	TriangulationWorkspace() : delaunay_(nullptr, 0)											{ };
+
+	// Which sets this worker did, where each one's triangles start in indices, and the triangles themselves
+	std::vector<int>									sets;
+	std::vector<size_t>									starts;
+	std::vector<int>									indices;
+
+	void												Clear();
+
+	// Triangulate one set and tack its triangles onto indices; returns how many there were
+	int													Triangulate(int set, const Coord* xy, int count);
+};
+
+//	--------------------------------------------------------
+//	The batch triangulator
+//	--------------------------------------------------------
+
+// Hang on to one of these: the threads and the workspaces both outlive a call, which is the whole point
+class BatchTriangulator
+{
+private:
+	TaskPool											tasks_;
+	std::vector<std::unique_ptr<TriangulationWorkspace>>	workspaces_;
+
+	void												Work(TriangulationWorkspace& workspace, const PointSets& sets, std::atomic<int>& next, TriangleSets& out);
+	void												Gather(TriangulationWorkspace& workspace, TriangleSets& out);
+	void												RunWorkers(const std::function<void(TriangulationWorkspace&)>& work);
+
+public:
+	BatchTriangulator(int threads = 1);
+
+	// Triangulate every set; out gets resized to fit, so reusing it between calls saves the allocation
+	void												Triangulate(const PointSets& sets, TriangleSets& out);
+};
+
+// Sets are handed out this many at a time, which keeps the shared counter quiet without hurting the balance much
+const int SETS_PER_GRAB = 16;
+
+//	--------------------------------------------------------
+//	PointSets member functions
+//	--------------------------------------------------------
+
+void PointSets::Add(const Coord* records, int count)
+{
+	xy.insert(xy.end(), records, records + 2 * (size_t)count);
+	offsets.push_back(offsets.back() + count);
+}
+
+void PointSets::Clear()
+{
+	xy.clear();
+	offsets.assign(1, 0);
+}
+
+//	--------------------------------------------------------
+//	TriangulationWorkspace member functions
+//	--------------------------------------------------------
+
+void TriangulationWorkspace::Clear()
+{
+	sets.clear();
+	starts.clear();
+	indices.clear();
+}
+
+int TriangulationWorkspace::Triangulate(int set, const Coord* xy, int count)
+{
+	delaunay_.Retriangulate(xy, count);
+	delaunay_.GetTriangles(triangles_);
+
+	// GetTriangles speaks in sorted vertex ids; the caller wants their own record indices back
+	const std::vector<int>& sources = delaunay_.GetSources();
+	sets.push_back(set);
+	starts.push_back(indices.size());
+	for (auto i = triangles_.begin(); i != triangles_.end(); i++)
+	{
+		indices.push_back(sources[*i]);
+	}
+
+	return triangles_.size() / 3;
+}
+
+//	--------------------------------------------------------
+//	BatchTriangulator
+//	--------------------------------------------------------
+
+BatchTriangulator::BatchTriangulator(int threads) : tasks_(threads)
+{
+	for (int i = 0; i < tasks_.size(); i++)
+	{
+		workspaces_.push_back(std::unique_ptr<TriangulationWorkspace>(new TriangulationWorkspace()));
+	}
+}
+
+void BatchTriangulator::RunWorkers(const std::function<void(TriangulationWorkspace&)>& work)
+{
+	// One task per workspace, so no two threads ever share one, whoever ends up running which task
+	if (workspaces_.size() == 1)
+	{
+		work(*workspaces_[0]);
+		return;
+	}
+
+	std::vector<std::unique_ptr<Task>> running;
+	for (auto i = workspaces_.begin(); i != workspaces_.end(); i++)
+	{
+		TriangulationWorkspace* workspace = i->get();
+		running.push_back(std::unique_ptr<Task>(new Task([&work, workspace]() { work(*workspace); })));
+		tasks_.Fork(*running.back());
+	}
+	for (auto i = running.begin(); i != running.end(); i++)
+	{
+		tasks_.Join(**i);
+	}
+}
+
+void BatchTriangulator::Work(TriangulationWorkspace& workspace, const PointSets& sets, std::atomic<int>& next, TriangleSets& out)
+{
+	// Grab sets off the shared counter until they run out; a worker stuck on a big set just grabs fewer
+	workspace.Clear();
+	int count = sets.SetCount();
+	for (int begin = next.fetch_add(SETS_PER_GRAB); begin < count; begin = next.fetch_add(SETS_PER_GRAB))
+	{
+		int end = std::min(begin + SETS_PER_GRAB, count);
+		for (int s = begin; s < end; s++)
+		{
+			// Every set has its own counting slot, so nobody needs a lock to fill them in
+			out.first_triangle[s + 1] = workspace.Triangulate(s, sets.Records(s), sets.Size(s));
+		}
+	}
+}
+
+void BatchTriangulator::Gather(TriangulationWorkspace& workspace, TriangleSets& out)
+{
+	// The slots for each set are already worked out, and only this workspace did that set, so the copies never overlap
+	for (int k = 0; k < workspace.sets.size(); k++)
+	{
+		int s = workspace.sets[k];
+		size_t length = 3 * (size_t)out.TriangleCount(s);
+		if (length > 0)
+		{
+			memcpy(out.indices.data() + 3 * (size_t)out.first_triangle[s], workspace.indices.data() + workspace.starts[k], length * sizeof(int));
+		}
+	}
+}
+
+void BatchTriangulator::Triangulate(const PointSets& sets, TriangleSets& out)
+{
+	// Count as we go, sum the counts into offsets, then copy everything into its slot
+	int count = sets.SetCount();
+	out.first_triangle.assign(count + 1, 0);
+
+	std::atomic<int> next(0);
+	RunWorkers([this, &sets, &next, &out](TriangulationWorkspace& workspace) { Work(workspace, sets, next, out); });
+
+	for (int s = 0; s < count; s++)
+	{
+		out.first_triangle[s + 1] += out.first_triangle[s];
+	}
+
+	out.indices.resize(3 * (size_t)out.first_triangle[count]);
+	RunWorkers([this, &out](TriangulationWorkspace& workspace) { Gather(workspace, out); });
+}
+
+//	--------------------------------------------------------
+
+#endif
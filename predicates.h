@@ -0,0 +1,501 @@
+//	--------------------------------------------------------
+//	PREDICATES.H
+//	--------------------------------------------------------
+//	Contains robust orientation and in-circle tests
+//	Each one tries a plain floating-point evaluation with an error bound first, and only redoes it exactly when that can't decide
+//	Following Shewchuk, Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric Predicates (1997)
+//	--------------------------------------------------------
+
+#ifndef PREDICATES_H
+#define PREDICATES_H
+
+//	--------------------------------------------------------
+//	Include
+//	--------------------------------------------------------
+
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+//	--------------------------------------------------------
+//	Bookkeeping
+//	--------------------------------------------------------
+
+// How many times each filter gave up and we had to go exact
+// Only bumped on the slow path, so the fast path doesn't pay for it
+struct PredicateStats
+{
+	std::atomic<unsigned long long>						orient_exact;
+	std::atomic<unsigned long long>						incircle_exact;
+};
+
+PredicateStats PREDICATE_STATS = {};
+
+//	--------------------------------------------------------
+//	Error-free transformations
+//	--------------------------------------------------------
+
+// These turn one rounded operation into a rounded result plus the exact error, so nothing is ever lost
+// (Don't build this with -ffast-math or anything else that lets the compiler reassociate)
+
+void TwoSum(double a, double b, double& x, double& y)
+{
+	x = a + b;
+	double b_virtual = x - a;
+	double a_virtual = x - b_virtual;
+	y = (a - a_virtual) + (b - b_virtual);
+}
+
+void FastTwoSum(double a, double b, double& x, double& y)
+{
+	// Only valid when |a| >= |b|
+	x = a + b;
+	y = b - (x - a);
+}
+
+void TwoDiff(double a, double b, double& x, double& y)
+{
+	x = a - b;
+	double b_virtual = a - x;
+	double a_virtual = x + b_virtual;
+	y = (a - a_virtual) + (b_virtual - b);
+}
+
+void TwoProduct(double a, double b, double& x, double& y)
+{
+	// The fused multiply-add hands us the rounding error of a * b for free
+	x = a * b;
+	y = std::fma(a, b, -x);
+}
+
+//	--------------------------------------------------------
+//	Expansion arithmetic
+//	--------------------------------------------------------
+
+// An expansion is an array of non-overlapping doubles, smallest magnitude first, whose exact sum is the value
+// Zeroes get dropped as we go, so easy inputs stay short
+
+int ExpansionSum(int e_length, const double* e, int f_length, const double* f, double* h)
+{
+	// h = e + f; h needs room for e_length + f_length components
+	int e_index = 0;
+	int f_index = 0;
+	int h_index = 0;
+	double e_now = e[0];
+	double f_now = f[0];
+	double q;
+	double q_new;
+	double hh;
+
+	if ((f_now > e_now) == (f_now > -e_now))
+	{
+		q = e_now;
+		e_now = (++e_index < e_length) ? e[e_index] : 0;
+	}
+	else
+	{
+		q = f_now;
+		f_now = (++f_index < f_length) ? f[f_index] : 0;
+	}
+
+	if (e_index < e_length && f_index < f_length)
+	{
+		if ((f_now > e_now) == (f_now > -e_now))
+		{
+			FastTwoSum(e_now, q, q_new, hh);
+			e_now = (++e_index < e_length) ? e[e_index] : 0;
+		}
+		else
+		{
+			FastTwoSum(f_now, q, q_new, hh);
+			f_now = (++f_index < f_length) ? f[f_index] : 0;
+		}
+		q = q_new;
+		if (hh != 0)
+		{
+			h[h_index++] = hh;
+		}
+
+		while (e_index < e_length && f_index < f_length)
+		{
+			if ((f_now > e_now) == (f_now > -e_now))
+			{
+				TwoSum(q, e_now, q_new, hh);
+				e_now = (++e_index < e_length) ? e[e_index] : 0;
+			}
+			else
+			{
+				TwoSum(q, f_now, q_new, hh);
+				f_now = (++f_index < f_length) ? f[f_index] : 0;
+			}
+			q = q_new;
+			if (hh != 0)
+			{
+				h[h_index++] = hh;
+			}
+		}
+	}
+
+	while (e_index < e_length)
+	{
+		TwoSum(q, e_now, q_new, hh);
+		e_now = (++e_index < e_length) ? e[e_index] : 0;
+		q = q_new;
+		if (hh != 0)
+		{
+			h[h_index++] = hh;
+		}
+	}
+
+	while (f_index < f_length)
+	{
+		TwoSum(q, f_now, q_new, hh);
+		f_now = (++f_index < f_length) ? f[f_index] : 0;
+		q = q_new;
+		if (hh != 0)
+		{
+			h[h_index++] = hh;
+		}
+	}
+
+	if (q != 0 || h_index == 0)
+	{
+		h[h_index++] = q;
+	}
+
+	return h_index;
+}
+
+int ScaleExpansion(int e_length, const double* e, double b, double* h)
+{
+	// h = b * e; h needs room for 2 * e_length components
+	int h_index = 0;
+	double q;
+	double hh;
+
+	TwoProduct(e[0], b, q, hh);
+	if (hh != 0)
+	{
+		h[h_index++] = hh;
+	}
+
+	for (int i = 1; i < e_length; i++)
+	{
+		double product_hi;
+		double product_lo;
+		double sum;
+
+		TwoProduct(e[i], b, product_hi, product_lo);
+		TwoSum(q, product_lo, sum, hh);
+		if (hh != 0)
+		{
+			h[h_index++] = hh;
+		}
+		FastTwoSum(product_hi, sum, q, hh);
+		if (hh != 0)
+		{
+			h[h_index++] = hh;
+		}
+	}
+
+	if (q != 0 || h_index == 0)
+	{
+		h[h_index++] = q;
+	}
+
+	return h_index;
+}
+
+// Biggest operands ExpansionProduct will take; the in-circle test never needs more than this
+const int EXPANSION_PRODUCT_MAX = 16;
+
+int ExpansionProduct(int e_length, const double* e, int f_length, const double* f, double* h)
+{
+	// h = e * f, one scaled copy of e per component of f, summed up; h needs room for 2 * e_length * f_length components
+	double scaled[2 * EXPANSION_PRODUCT_MAX];
+	double partial[2][2 * EXPANSION_PRODUCT_MAX * EXPANSION_PRODUCT_MAX];
+
+	int length = ScaleExpansion(e_length, e, f[0], partial[0]);
+	int current = 0;
+
+	for (int i = 1; i < f_length; i++)
+	{
+		int scaled_length = ScaleExpansion(e_length, e, f[i], scaled);
+		length = ExpansionSum(length, partial[current], scaled_length, scaled, partial[1 - current]);
+		current = 1 - current;
+	}
+
+	for (int i = 0; i < length; i++)
+	{
+		h[i] = partial[current][i];
+	}
+
+	return length;
+}
+
+int ExpansionNegate(int e_length, double* e)
+{
+	for (int i = 0; i < e_length; i++)
+	{
+		e[i] = -e[i];
+	}
+
+	return e_length;
+}
+
+//	--------------------------------------------------------
+//	Orientation
+//	--------------------------------------------------------
+
+double Orient2dExact(double a_x, double a_y, double b_x, double b_y, double c_x, double c_y)
+{
+	// Expand the determinant into its six products and add them up without rounding anything
+	double products[6][2];
+	TwoProduct(a_x, b_y, products[0][1], products[0][0]);
+	TwoProduct(-a_x, c_y, products[1][1], products[1][0]);
+	TwoProduct(-a_y, b_x, products[2][1], products[2][0]);
+	TwoProduct(a_y, c_x, products[3][1], products[3][0]);
+	TwoProduct(b_x, c_y, products[4][1], products[4][0]);
+	TwoProduct(-b_y, c_x, products[5][1], products[5][0]);
+
+	double sum[2][12];
+	int length = 2;
+	int current = 0;
+	sum[0][0] = products[0][0];
+	sum[0][1] = products[0][1];
+
+	for (int i = 1; i < 6; i++)
+	{
+		length = ExpansionSum(length, sum[current], 2, products[i], sum[1 - current]);
+		current = 1 - current;
+	}
+
+	// The biggest component carries the sign
+	return sum[current][length - 1];
+}
+
+double Orient2d(double a_x, double a_y, double b_x, double b_y, double c_x, double c_y)
+{
+	// Positive if a, b, c wind counterclockwise, negative if clockwise, zero if they're collinear
+	double left = (a_x - c_x) * (b_y - c_y);
+	double right = (a_y - c_y) * (b_x - c_x);
+	double det = left - right;
+
+	// If the two products have opposite signs (or one is zero), there's no cancellation and the sign is already right
+	double det_sum;
+	if (left > 0)
+	{
+		if (right <= 0)
+		{
+			return det;
+		}
+		det_sum = left + right;
+	}
+	else if (left < 0)
+	{
+		if (right >= 0)
+		{
+			return det;
+		}
+		det_sum = -left - right;
+	}
+	else
+	{
+		return det;
+	}
+
+	const double epsilon = DBL_EPSILON / 2;
+	const double bound = (3 + 16 * epsilon) * epsilon * det_sum;
+	if (det >= bound || -det >= bound)
+	{
+		return det;
+	}
+
+	PREDICATE_STATS.orient_exact.fetch_add(1, std::memory_order_relaxed);
+	return Orient2dExact(a_x, a_y, b_x, b_y, c_x, c_y);
+}
+
+//	--------------------------------------------------------
+//	In-circle
+//	--------------------------------------------------------
+
+double InCircle2dExact(double a_x, double a_y, double b_x, double b_y, double c_x, double c_y, double d_x, double d_y)
+{
+	// Translate so d sits at the origin, keeping each difference exact as a two-component expansion
+	double ad_x[2], ad_y[2], bd_x[2], bd_y[2], cd_x[2], cd_y[2];
+	TwoDiff(a_x, d_x, ad_x[1], ad_x[0]);
+	TwoDiff(a_y, d_y, ad_y[1], ad_y[0]);
+	TwoDiff(b_x, d_x, bd_x[1], bd_x[0]);
+	TwoDiff(b_y, d_y, bd_y[1], bd_y[0]);
+	TwoDiff(c_x, d_x, cd_x[1], cd_x[0]);
+	TwoDiff(c_y, d_y, cd_y[1], cd_y[0]);
+
+	const double* x[3] = { ad_x, bd_x, cd_x };
+	const double* y[3] = { ad_y, bd_y, cd_y };
+
+	double total[2][3 * 2 * EXPANSION_PRODUCT_MAX * EXPANSION_PRODUCT_MAX];
+	int total_length = 1;
+	int current = 0;
+	total[0][0] = 0;
+
+	for (int i = 0; i < 3; i++)
+	{
+		// The term for vertex i is its lifted length times the 2x2 determinant of the other two
+		const double* j_x = x[(i + 1) % 3];
+		const double* j_y = y[(i + 1) % 3];
+		const double* k_x = x[(i + 2) % 3];
+		const double* k_y = y[(i + 2) % 3];
+
+		double t0[8], t1[8], minor[16];
+		int t0_length = ExpansionProduct(2, j_x, 2, k_y, t0);
+		int t1_length = ExpansionNegate(ExpansionProduct(2, k_x, 2, j_y, t1), t1);
+		int minor_length = ExpansionSum(t0_length, t0, t1_length, t1, minor);
+
+		double xx[8], yy[8], lift[16];
+		int xx_length = ExpansionProduct(2, x[i], 2, x[i], xx);
+		int yy_length = ExpansionProduct(2, y[i], 2, y[i], yy);
+		int lift_length = ExpansionSum(xx_length, xx, yy_length, yy, lift);
+
+		double term[2 * EXPANSION_PRODUCT_MAX * EXPANSION_PRODUCT_MAX];
+		int term_length = ExpansionProduct(lift_length, lift, minor_length, minor, term);
+
+		total_length = ExpansionSum(total_length, total[current], term_length, term, total[1 - current]);
+		current = 1 - current;
+	}
+
+	return total[current][total_length - 1];
+}
+
+double InCircle2d(double a_x, double a_y, double b_x, double b_y, double c_x, double c_y, double d_x, double d_y)
+{
+	// Positive if d lies inside the circle through a, b, c (taken counterclockwise), negative if outside, zero if on it
+	double ad_x = a_x - d_x;
+	double bd_x = b_x - d_x;
+	double cd_x = c_x - d_x;
+	double ad_y = a_y - d_y;
+	double bd_y = b_y - d_y;
+	double cd_y = c_y - d_y;
+
+	double bd_x_cd_y = bd_x * cd_y;
+	double cd_x_bd_y = cd_x * bd_y;
+	double a_lift = ad_x * ad_x + ad_y * ad_y;
+
+	double cd_x_ad_y = cd_x * ad_y;
+	double ad_x_cd_y = ad_x * cd_y;
+	double b_lift = bd_x * bd_x + bd_y * bd_y;
+
+	double ad_x_bd_y = ad_x * bd_y;
+	double bd_x_ad_y = bd_x * ad_y;
+	double c_lift = cd_x * cd_x + cd_y * cd_y;
+
+	double det = a_lift * (bd_x_cd_y - cd_x_bd_y) + b_lift * (cd_x_ad_y - ad_x_cd_y) + c_lift * (ad_x_bd_y - bd_x_ad_y);
+
+	// Same sum with everything made positive, which bounds how much rounding could have crept in
+	double permanent = (std::fabs(bd_x_cd_y) + std::fabs(cd_x_bd_y)) * a_lift
+					 + (std::fabs(cd_x_ad_y) + std::fabs(ad_x_cd_y)) * b_lift
+					 + (std::fabs(ad_x_bd_y) + std::fabs(bd_x_ad_y)) * c_lift;
+
+	const double epsilon = DBL_EPSILON / 2;
+	const double bound = (10 + 96 * epsilon) * epsilon * permanent;
+	if (det > bound || -det > bound)
+	{
+		return det;
+	}
+
+	PREDICATE_STATS.incircle_exact.fetch_add(1, std::memory_order_relaxed);
+	return InCircle2dExact(a_x, a_y, b_x, b_y, c_x, c_y, d_x, d_y);
+}
+
+//	--------------------------------------------------------
+//	Integer coordinates
+//	--------------------------------------------------------
+
+// With integer inputs the determinants are integers too, so a wide enough integer type gets them exactly without any filter
+// The 128-bit type is a GCC/Clang extension; without it, integers go through the double versions above, which are still exact below 2^53
+
+// Coordinates below this keep their differences under 2^30, so each lifted term of the in-circle determinant stays under 2^122
+const int64_t INTEGER_INCIRCLE_BOUND = (int64_t)1 << 29;
+
+// And below this, differences still fit in 64 bits for the orientation test
+const int64_t INTEGER_ORIENT_BOUND = (int64_t)1 << 62;
+
+bool WithinBound(int64_t v, int64_t bound)
+{
+	return v < bound && v > -bound;
+}
+
+double IntegerOrient2d(int64_t a_x, int64_t a_y, int64_t b_x, int64_t b_y, int64_t c_x, int64_t c_y)
+{
+#if defined(__SIZEOF_INT128__)
+	if (WithinBound(a_x, INTEGER_ORIENT_BOUND) && WithinBound(a_y, INTEGER_ORIENT_BOUND) && WithinBound(b_x, INTEGER_ORIENT_BOUND)
+		&& WithinBound(b_y, INTEGER_ORIENT_BOUND) && WithinBound(c_x, INTEGER_ORIENT_BOUND) && WithinBound(c_y, INTEGER_ORIENT_BOUND))
+	{
+		__int128 det = (__int128)(a_x - c_x) * (b_y - c_y) - (__int128)(a_y - c_y) * (b_x - c_x);
+		return (det > 0) ? 1 : ((det < 0) ? -1 : 0);
+	}
+#endif
+
+	return Orient2d((double)a_x, (double)a_y, (double)b_x, (double)b_y, (double)c_x, (double)c_y);
+}
+
+double IntegerInCircle2d(int64_t a_x, int64_t a_y, int64_t b_x, int64_t b_y, int64_t c_x, int64_t c_y, int64_t d_x, int64_t d_y)
+{
+#if defined(__SIZEOF_INT128__)
+	if (WithinBound(a_x, INTEGER_INCIRCLE_BOUND) && WithinBound(a_y, INTEGER_INCIRCLE_BOUND) && WithinBound(b_x, INTEGER_INCIRCLE_BOUND)
+		&& WithinBound(b_y, INTEGER_INCIRCLE_BOUND) && WithinBound(c_x, INTEGER_INCIRCLE_BOUND) && WithinBound(c_y, INTEGER_INCIRCLE_BOUND)
+		&& WithinBound(d_x, INTEGER_INCIRCLE_BOUND) && WithinBound(d_y, INTEGER_INCIRCLE_BOUND))
+	{
+		// Same expansion as InCircle2d; the minors and lifts fit in 64 bits, only their products need the wide type
+		int64_t ad_x = a_x - d_x;
+		int64_t bd_x = b_x - d_x;
+		int64_t cd_x = c_x - d_x;
+		int64_t ad_y = a_y - d_y;
+		int64_t bd_y = b_y - d_y;
+		int64_t cd_y = c_y - d_y;
+
+		int64_t a_lift = ad_x * ad_x + ad_y * ad_y;
+		int64_t b_lift = bd_x * bd_x + bd_y * bd_y;
+		int64_t c_lift = cd_x * cd_x + cd_y * cd_y;
+
+		__int128 det = (__int128)a_lift * (bd_x * cd_y - cd_x * bd_y)
+					 + (__int128)b_lift * (cd_x * ad_y - ad_x * cd_y)
+					 + (__int128)c_lift * (ad_x * bd_y - bd_x * ad_y);
+		return (det > 0) ? 1 : ((det < 0) ? -1 : 0);
+	}
+#endif
+
+	return InCircle2d((double)a_x, (double)a_y, (double)b_x, (double)b_y, (double)c_x, (double)c_y, (double)d_x, (double)d_y);
+}
+
+// Whichever of the two families fits the coordinate type; if constexpr means the other one never gets instantiated for T
+template <typename T>
+double Orient2dOf(T a_x, T a_y, T b_x, T b_y, T c_x, T c_y)
+{
+	if constexpr (std::is_integral<T>::value)
+	{
+		return IntegerOrient2d((int64_t)a_x, (int64_t)a_y, (int64_t)b_x, (int64_t)b_y, (int64_t)c_x, (int64_t)c_y);
+	}
+	else
+	{
+		return Orient2d((double)a_x, (double)a_y, (double)b_x, (double)b_y, (double)c_x, (double)c_y);
+	}
+}
+
+template <typename T>
+double InCircle2dOf(T a_x, T a_y, T b_x, T b_y, T c_x, T c_y, T d_x, T d_y)
+{
+	if constexpr (std::is_integral<T>::value)
+	{
+		return IntegerInCircle2d((int64_t)a_x, (int64_t)a_y, (int64_t)b_x, (int64_t)b_y, (int64_t)c_x, (int64_t)c_y, (int64_t)d_x, (int64_t)d_y);
+	}
+	else
+	{
+		return InCircle2d((double)a_x, (double)a_y, (double)b_x, (double)b_y, (double)c_x, (double)c_y, (double)d_x, (double)d_y);
+	}
+}
+
+//	--------------------------------------------------------
+
+#endif
@@ -0,0 +1,214 @@
+//	--------------------------------------------------------
+//	PRESORT.H
+//	--------------------------------------------------------
+//	Contains the sorting stage in front of the triangulation
+//	Each point becomes one 64-bit key that orders the same way as (x, y) lexicographically, and the keys get an LSD radix sort
+//	(Coordinate types too wide for that get an ordinary comparison sort)
+//	--------------------------------------------------------
+
+#ifndef PRESORT_H
+#define PRESORT_H
+
+//	--------------------------------------------------------
+//	Include
+//	--------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+//	--------------------------------------------------------
+//	Keys
+//	--------------------------------------------------------
+
+// Reinterprets a float so that unsigned integer order matches float order
+// Positive floats just need the sign bit set to land above the negatives; negative ones sort backwards, so flip them entirely
+uint32_t SortableBits(float f)
+{
+	// -0 and +0 compare equal, so they'd better get the same key
+	if (f == 0)
+	{
+		f = 0;
+	}
+
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+// Two's complement just needs the sign bit flipped
+uint32_t SortableBits(int32_t v)
+{
+	return (uint32_t)v ^ 0x80000000u;
+}
+
+// x in the high half, y in the low half, so the key order is the lexicographic order Triangulate needs
+uint64_t PointKey(float x, float y)
+{
+	return ((uint64_t)SortableBits(x) << 32) | SortableBits(y);
+}
+
+uint64_t PointKey(int32_t x, int32_t y)
+{
+	return ((uint64_t)SortableBits(x) << 32) | SortableBits(y);
+}
+
+//	--------------------------------------------------------
+//	The sort
+//	--------------------------------------------------------
+
+// Below this, the histograms cost more than they save
+const int RADIX_CUTOFF = 256;
+
+// 11-bit digits: six passes cover 64 bits, and one histogram still sits comfortably in L1
+const int RADIX_BITS = 11;
+const int RADIX_DIGITS = 6;
+const int RADIX_BUCKETS = 1 << RADIX_BITS;
+const uint64_t RADIX_MASK = RADIX_BUCKETS - 1;
+
+// Sorts keys, carrying order along; least significant digit first
+void RadixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& order)
+{
+	size_t n = keys.size();
+	if (n < RADIX_CUTOFF)
+	{
+		std::vector<std::pair<uint64_t, uint32_t>> pairs(n);
+		for (size_t i = 0; i < n; i++)
+		{
+			pairs[i] = std::make_pair(keys[i], order[i]);
+		}
+		std::sort(pairs.begin(), pairs.end());
+		for (size_t i = 0; i < n; i++)
+		{
+			keys[i] = pairs[i].first;
+			order[i] = pairs[i].second;
+		}
+		return;
+	}
+
+	// All the histograms in one read
+	std::vector<size_t> counts(RADIX_DIGITS * RADIX_BUCKETS, 0);
+	for (size_t i = 0; i < n; i++)
+	{
+		uint64_t k = keys[i];
+		for (int d = 0; d < RADIX_DIGITS; d++)
+		{
+			counts[d * RADIX_BUCKETS + ((k >> (RADIX_BITS * d)) & RADIX_MASK)]++;
+		}
+	}
+
+	std::vector<uint64_t> key_buffer(n);
+	std::vector<uint32_t> order_buffer(n);
+
+	for (int d = 0; d < RADIX_DIGITS; d++)
+	{
+		size_t* count = &counts[d * RADIX_BUCKETS];
+		int shift = RADIX_BITS * d;
+
+		// A digit that's the same for every key wouldn't move anything; for points in a small box most of the high ones are
+		if (count[(keys[0] >> shift) & RADIX_MASK] == n)
+		{
+			continue;
+		}
+
+		size_t offset = 0;
+		for (int b = 0; b < RADIX_BUCKETS; b++)
+		{
+			size_t c = count[b];
+			count[b] = offset;
+			offset += c;
+		}
+
+		for (size_t i = 0; i < n; i++)
+		{
+			size_t slot = count[(keys[i] >> shift) & RADIX_MASK]++;
+			key_buffer[slot] = keys[i];
+			order_buffer[slot] = order[i];
+		}
+
+		keys.swap(key_buffer);
+		order.swap(order_buffer);
+	}
+}
+
+// Keys and record indices of every finite (x, y) record, sorted
+// Duplicates come out next to each other with equal keys, lowest record index first, so the caller can drop them on the way past
+// This is for coordinate types whose two halves fit in one 64-bit key (float and int32)
+template <typename T>
+void SortPointsRadix(const T* xy, int count, std::vector<uint64_t>& keys, std::vector<uint32_t>& order)
+{
+	keys.clear();
+	order.clear();
+	keys.reserve(count);
+	order.reserve(count);
+
+	// Anything that isn't a finite number can't be ordered, so it gets dropped here
+	for (int i = 0; i < count; i++)
+	{
+		if (std::isfinite(xy[2 * i]) && std::isfinite(xy[2 * i + 1]))
+		{
+			keys.push_back(PointKey(xy[2 * i], xy[2 * i + 1]));
+			order.push_back(i);
+		}
+	}
+
+	RadixSort(keys, order);
+}
+
+void SortPoints(const float* xy, int count, std::vector<uint64_t>& keys, std::vector<uint32_t>& order)
+{
+	SortPointsRadix(xy, count, keys, order);
+}
+
+void SortPoints(const int32_t* xy, int count, std::vector<uint64_t>& keys, std::vector<uint32_t>& order)
+{
+	SortPointsRadix(xy, count, keys, order);
+}
+
+// Doubles and 64-bit integers need 128 bits for a key, so they get a comparison sort instead
+// The keys handed back are just ranks: equal for duplicates and increasing otherwise, which is all anybody downstream looks at
+template <typename T>
+void SortPoints(const T* xy, int count, std::vector<uint64_t>& keys, std::vector<uint32_t>& order)
+{
+	keys.clear();
+	order.clear();
+	order.reserve(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		if (std::isfinite((double)xy[2 * i]) && std::isfinite((double)xy[2 * i + 1]))
+		{
+			order.push_back(i);
+		}
+	}
+
+	// Ties on position fall back to the record index, so the first record of each duplicate run is still the lowest
+	std::sort(order.begin(), order.end(), [xy](uint32_t a, uint32_t b)
+	{
+		const T* p = xy + 2 * (size_t)a;
+		const T* q = xy + 2 * (size_t)b;
+		return (p[0] < q[0]) || (p[0] == q[0] && (p[1] < q[1] || (p[1] == q[1] && a < b)));
+	});
+
+	keys.resize(order.size());
+	uint64_t rank = 0;
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		if (i > 0)
+		{
+			const T* p = xy + 2 * (size_t)order[i - 1];
+			const T* q = xy + 2 * (size_t)order[i];
+			if (p[0] != q[0] || p[1] != q[1])
+			{
+				rank++;
+			}
+		}
+		keys[i] = rank;
+	}
+}
+
+//	--------------------------------------------------------
+
+#endif
@@ -16,6 +16,9 @@
 
 #include "edge.h"
 #include <memory>
+#include <vector>
+
+class EdgeStore;
 
 //	--------------------------------------------------------
 //	The class
@@ -25,9 +28,38 @@ class QuadEdge
 {
 public:
 	Edge edges[4];
+
+	// Which store this guy came out of, and where it sits in that store's list of live QuadEdges
+	// That way it can be pulled out without a search, even by a thread that didn't make it
+	EdgeStore* store;
+	int slot;
+
 	QuadEdge();
 };
 
+//	--------------------------------------------------------
+//	The store the QuadEdges live in
+//	--------------------------------------------------------
+
+// A pool to allocate QuadEdges from, plus a dense list of the live ones
+// The parallel triangulation gives each forked subtree its own, so making edges never contends
+class EdgeStore
+{
+public:
+	Pool<QuadEdge>										pool;
+	std::vector<QuadEdge*>								quads;
+
+	QuadEdge*											Make();
+	void												Release(QuadEdge* quad);
+	void												Clear();
+
+	// Same, but keep the pool's blocks and the list's capacity for the next triangulation
+	void												Reset();
+
+	// Move another store's QuadEdges into quads[offset...], which the caller has already sized
+	void												Absorb(EdgeStore& other, int offset);
+};
+
 //	--------------------------------------------------------
 //	Constructor
 //	--------------------------------------------------------
@@ -53,17 +85,68 @@ QuadEdge::QuadEdge()
 	edges[3].setNext((edges + 1));
 }
 
+//	--------------------------------------------------------
+//	EdgeStore member functions
+//	--------------------------------------------------------
+
+QuadEdge* EdgeStore::Make()
+{
+	QuadEdge* quad = pool.Make();
+	quad->store = this;
+	quad->slot = quads.size();
+	quads.push_back(quad);
+	return quad;
+}
+
+void EdgeStore::Release(QuadEdge* quad)
+{
+	// Swap the last quad edge into this one's slot so removal doesn't have to search the list
+	QuadEdge* last = quads.back();
+	quads[quad->slot] = last;
+	last->slot = quad->slot;
+	quads.pop_back();
+
+	pool.Release(quad);
+}
+
+void EdgeStore::Clear()
+{
+	quads.clear();
+	pool.Clear();
+}
+
+void EdgeStore::Reset()
+{
+	quads.clear();
+	pool.Reset();
+}
+
+void EdgeStore::Absorb(EdgeStore& other, int offset)
+{
+	// Only touches other's QuadEdges and our own slots [offset, offset + other.quads.size()), so these can run side by side
+	// The caller still has to Adopt() the other pool's memory
+	for (int i = 0; i < other.quads.size(); i++)
+	{
+		QuadEdge* quad = other.quads[i];
+		quad->store = this;
+		quad->slot = offset + i;
+		quads[offset + i] = quad;
+	}
+
+	other.quads.clear();
+}
+
 //	--------------------------------------------------------
 //	This function depends on the definition of QuadEdge, so has to sit here
 //	--------------------------------------------------------
 
-Edge* Edge::Make(std::vector<QuadEdge*>& list)
+Edge* Edge::Make(EdgeStore& store)
 {
 	// To create a new Edge, make sure to call this function
-	// Create a QuadEdge to hold our new Edge and make aure we keep trck of it
-	list.push_back(new QuadEdge());
+	// Create a QuadEdge to hold our new Edge out of the store and make aure we keep trck of it
 	// Return the index of the 0th edge
-	return list.back()->edges;
+	COUNT_CALL(COUNT_MAKE_EDGE);
+	return store.Make()->edges;
 }
 
 //	--------------------------------------------------------
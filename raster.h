@@ -0,0 +1,117 @@
+//	--------------------------------------------------------
+//	RASTER.H
+//	--------------------------------------------------------
+//	Contains the output grid for interpolating values at the vertices onto a dense raster (see Delaunay::GetRaster)
+//	Cells are sampled at their centres, and a cell no triangle covers keeps the grid's empty value
+//	--------------------------------------------------------
+
+#ifndef RASTER_H
+#define RASTER_H
+
+//	--------------------------------------------------------
+//	Include
+//	--------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+//	--------------------------------------------------------
+//	Interpolation modes
+//	--------------------------------------------------------
+
+enum RasterMode
+{
+	RASTER_LINEAR,			// Barycentric within each triangle: continuous, but creased along the edges
+	RASTER_NATURAL			// Sibson's natural neighbours: smooth everywhere but at the vertices, and a good deal slower
+};
+
+//	--------------------------------------------------------
+//	The struct
+//	--------------------------------------------------------
+
+// Cell (i, j) is centred on (x0 + (i + 0.5) * cell_width, y0 + (j + 0.5) * cell_height) and sits at values[j * width + i]
+// Set up the shape and let GetRaster fill in values; it gets resized to fit, so reusing a grid saves the allocation
+struct RasterGrid
+{
+	int													width;
+	int													height;
+	double												x0;
+	double												y0;
+	double												cell_width;
+	double												cell_height;
+	float												empty;
+	std::vector<float>									values;
+
+	RasterGrid() : width(0), height(0), x0(0), y0(0), cell_width(1), cell_height(1), empty(std::numeric_limits<float>::quiet_NaN())	{ };
+	RasterGrid(int w, int h, double left, double bottom, double cw, double ch)
+		: width(w), height(h), x0(left), y0(bottom), cell_width(cw), cell_height(ch), empty(std::numeric_limits<float>::quiet_NaN())	{ };
+
+	double												CellX(int i) const						{ return x0 + (i + 0.5) * cell_width; };
+	double												CellY(int j) const						{ return y0 + (j + 0.5) * cell_height; };
+	float												At(int i, int j) const					{ return values[(size_t)j * width + i]; };
+};
+
+// The grid gets cut into square tiles of this many cells a side, and the tiles are what the threads split up
+// Every triangle is filed under each tile its bounding box touches, so no two threads ever write the same cell
+const int RASTER_TILE = 64;
+
+//	--------------------------------------------------------
+//	Scanline helpers
+//	--------------------------------------------------------
+
+// The first and last cells whose centres lie within [lo, hi] along one axis, clamped well inside int
+int FirstCell(double lo, double origin, double size)
+{
+	double t = std::ceil((lo - origin) / size - 0.5);
+	return (int)std::max(-1.0, std::min(t, 1e9));
+}
+
+int LastCell(double hi, double origin, double size)
+{
+	double t = std::floor((hi - origin) / size - 0.5);
+	return (int)std::max(-1.0, std::min(t, 1e9));
+}
+
+// Where the horizontal line at height row crosses the triangle (x[k], y[k]); false if it misses
+// Each side is worked out from its lower end, so the two triangles sharing it get bit-for-bit the same crossing and no cell falls in the crack
+bool RowSpan(const double* x, const double* y, double row, double& lo, double& hi)
+{
+	bool hit = false;
+	lo = std::numeric_limits<double>::infinity();
+	hi = -lo;
+	for (int k = 0; k < 3; k++)
+	{
+		int a = k;
+		int b = (k + 1) % 3;
+		if (y[b] < y[a] || (y[b] == y[a] && x[b] < x[a]))
+		{
+			std::swap(a, b);
+		}
+		if (row < y[a] || row > y[b])
+		{
+			continue;
+		}
+
+		if (y[a] == y[b])
+		{
+			lo = std::min(lo, x[a]);
+			hi = std::max(hi, x[b]);
+		}
+		else
+		{
+			double cross = x[a] + (row - y[a]) * (x[b] - x[a]) / (y[b] - y[a]);
+			lo = std::min(lo, cross);
+			hi = std::max(hi, cross);
+		}
+		hit = true;
+	}
+
+	return hit;
+}
+
+//	--------------------------------------------------------
+
+#endif
@@ -0,0 +1,305 @@
+//	--------------------------------------------------------
+//	TASKS.H
+//	--------------------------------------------------------
+//	Contains a small work-stealing thread pool for fork-join recursion
+//	Every worker keeps its own deque: it pushes and pops its own forks at the back, and steals from the front of others when idle
+//	--------------------------------------------------------
+
+#ifndef TASKS_H
+#define TASKS_H
+
+//	--------------------------------------------------------
+//	Include
+//	--------------------------------------------------------
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//	--------------------------------------------------------
+//	The Task class
+//	--------------------------------------------------------
+
+// A unit of work that gets forked onto the pool; it lives on the stack of whoever forks it, so always Join() before returning
+class Task
+{
+private:
+	std::function<void()>								work_;
+	std::atomic<bool>									done_;
+
+	friend class TaskPool;
+
+public:
+	Task(std::function<void()> work) : work_(work), done_(false)				{ };
+
+	bool												done()									{ return done_.load(std::memory_order_acquire); };
+};
+
+//	--------------------------------------------------------
+//	The TaskPool class
+//	--------------------------------------------------------
+
+// Deque 0 belongs to the thread that calls in from outside, which pitches in whenever it waits on a Join()
+// Only one outside thread should drive a given pool at a time
+class TaskPool
+{
+private:
+	struct Worker
+	{
+		std::mutex										lock;
+		std::deque<Task*>								tasks;
+	};
+
+	std::vector<std::unique_ptr<Worker>>				workers_;
+	std::vector<std::thread>							threads_;
+	std::atomic<bool>									stop_;
+	std::atomic<int>									queued_;
+	std::mutex											sleep_lock_;
+	std::condition_variable								wake_;
+
+	// Which pool the current thread works for, and where its deque is
+	static thread_local TaskPool*						current_pool_;
+	static thread_local int								current_index_;
+
+	int													Index()									{ return (current_pool_ == this) ? current_index_ : 0; };
+	Task*												Pop(int index);
+	Task*												Steal(int thief);
+	void												Execute(Task* task);
+	void												Loop(int index);
+
+public:
+	TaskPool(int threads);
+	~TaskPool();
+
+	TaskPool(const TaskPool&) = delete;
+	TaskPool& operator=(const TaskPool&) = delete;
+
+	int													size()									{ return workers_.size(); };
+
+	// Make the task available to the pool, then wait for it (running other work meanwhile)
+	void												Fork(Task& task);
+	void												Join(Task& task);
+};
+
+thread_local TaskPool* TaskPool::current_pool_ = nullptr;
+thread_local int TaskPool::current_index_ = 0;
+
+//	--------------------------------------------------------
+//	Constructors and destructors
+//	--------------------------------------------------------
+
+TaskPool::TaskPool(int threads) : stop_(false), queued_(0)
+{
+	if (threads < 1)
+	{
+		threads = 1;
+	}
+
+	for (int i = 0; i < threads; i++)
+	{
+		workers_.push_back(std::unique_ptr<Worker>(new Worker()));
+	}
+
+	// The calling thread makes up the numbers, so we only need to spawn the rest
+	for (int i = 1; i < threads; i++)
+	{
+		threads_.push_back(std::thread(&TaskPool::Loop, this, i));
+	}
+}
+
+TaskPool::~TaskPool()
+{
+	{
+		std::lock_guard<std::mutex> guard(sleep_lock_);
+		stop_ = true;
+	}
+	wake_.notify_all();
+
+	for (auto i = threads_.begin(); i != threads_.end(); i++)
+	{
+		i->join();
+	}
+}
+
+//	--------------------------------------------------------
+//	Member functions
+//	--------------------------------------------------------
+
+Task* TaskPool::Pop(int index)
+{
+	// Newest first from our own deque, which keeps the recursion depth-first and cache-friendly
+	Worker* worker = workers_[index].get();
+	std::lock_guard<std::mutex> guard(worker->lock);
+
+	if (worker->tasks.empty())
+	{
+		return nullptr;
+	}
+
+	Task* task = worker->tasks.back();
+	worker->tasks.pop_back();
+	queued_--;
+	return task;
+}
+
+Task* TaskPool::Steal(int thief)
+{
+	// Oldest first from everybody else, since those are the biggest chunks of work
+	for (int i = 1; i < workers_.size(); i++)
+	{
+		Worker* victim = workers_[(thief + i) % workers_.size()].get();
+		std::lock_guard<std::mutex> guard(victim->lock);
+
+		if (!victim->tasks.empty())
+		{
+			Task* task = victim->tasks.front();
+			victim->tasks.pop_front();
+			queued_--;
+			return task;
+		}
+	}
+
+	return nullptr;
+}
+
+void TaskPool::Execute(Task* task)
+{
+	task->work_();
+	task->done_.store(true, std::memory_order_release);
+}
+
+void TaskPool::Loop(int index)
+{
+	current_pool_ = this;
+	current_index_ = index;
+
+	while (!stop_)
+	{
+		Task* task = Pop(index);
+		if (task == nullptr)
+		{
+			task = Steal(index);
+		}
+
+		if (task != nullptr)
+		{
+			Execute(task);
+			continue;
+		}
+
+		// Nothing to do, so nap until somebody forks
+		std::unique_lock<std::mutex> lock(sleep_lock_);
+		wake_.wait(lock, [this]() { return stop_ || queued_ > 0; });
+	}
+}
+
+void TaskPool::Fork(Task& task)
+{
+	Worker* worker = workers_[Index()].get();
+	{
+		std::lock_guard<std::mutex> guard(worker->lock);
+		worker->tasks.push_back(&task);
+		queued_++;
+	}
+
+	// Take the sleep lock so a worker can't miss this between checking the queue and going to sleep
+	{
+		std::lock_guard<std::mutex> guard(sleep_lock_);
+	}
+	wake_.notify_one();
+}
+
+void TaskPool::Join(Task& task)
+{
+	int index = Index();
+
+	// If nobody stole it, it's at the back of our deque and we just run it ourselves
+	// If somebody did, keep busy with whatever else is lying around until they're done
+	while (!task.done())
+	{
+		Task* other = Pop(index);
+		if (other == nullptr)
+		{
+			other = Steal(index);
+		}
+
+		if (other != nullptr)
+		{
+			Execute(other);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+//	--------------------------------------------------------
+//	Helpers
+//	--------------------------------------------------------
+
+// Sorts one run per worker side by side, then merges neighbouring runs pairwise, a round at a time, until there's one left
+// Same result as std::sort for any strict ordering that never calls two different items equal
+template <typename T>
+void ParallelSort(std::vector<T>& items, TaskPool& tasks)
+{
+	int runs = tasks.size();
+	size_t n = items.size();
+	if (runs <= 1 || n < 1024 * (size_t)runs)
+	{
+		std::sort(items.begin(), items.end());
+		return;
+	}
+
+	std::vector<size_t> bounds(runs + 1);
+	for (int r = 0; r <= runs; r++)
+	{
+		bounds[r] = n * r / runs;
+	}
+
+	std::vector<std::unique_ptr<Task>> work;
+	for (int r = 0; r < runs; r++)
+	{
+		typename std::vector<T>::iterator begin = items.begin() + bounds[r];
+		typename std::vector<T>::iterator end = items.begin() + bounds[r + 1];
+		work.push_back(std::unique_ptr<Task>(new Task([begin, end]() { std::sort(begin, end); })));
+		tasks.Fork(*work.back());
+	}
+	for (auto i = work.begin(); i != work.end(); i++)
+	{
+		tasks.Join(**i);
+	}
+
+	// Every round writes the whole buffer, copying a leftover run straight across, so the two can just trade places after
+	std::vector<T> buffer(n);
+	for (int width = 1; width < runs; width *= 2)
+	{
+		work.clear();
+		for (int r = 0; r < runs; r += 2 * width)
+		{
+			size_t low = bounds[r];
+			size_t middle = bounds[std::min(r + width, runs)];
+			size_t high = bounds[std::min(r + 2 * width, runs)];
+			work.push_back(std::unique_ptr<Task>(new Task([&items, &buffer, low, middle, high]()
+			{
+				std::merge(items.begin() + low, items.begin() + middle, items.begin() + middle, items.begin() + high, buffer.begin() + low);
+			})));
+			tasks.Fork(*work.back());
+		}
+		for (auto i = work.begin(); i != work.end(); i++)
+		{
+			tasks.Join(**i);
+		}
+		items.swap(buffer);
+	}
+}
+
+//	--------------------------------------------------------
+
+#endif
@@ -12,15 +12,30 @@
 //	Include files	
 //	--------------------------------------------------------
 
+#include "arena.h"
+#include "counters.h"
 #include "edge.h"
+#include "forest.h"
+#include "graph.h"
 #include "linal.h"
+#include "locator.h"
+#include "mesh.h"
+#include "presort.h"
 #include "quadedge.h"
+#include "raster.h"
+#include "tasks.h"
 #include "math.h"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <functional>
 #include <tuple>
 #include <vector>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <stdlib.h>
+#include <unordered_map>
 #include <unordered_set>
 
 //	--------------------------------------------------------
@@ -30,8 +45,28 @@
 typedef std::vector<Edge*>					EdgeList;
 typedef std::vector<Vert*>					PointsList;
 typedef std::vector<QuadEdge*>				QuadList;
-typedef std::tuple<EdgeList, EdgeList>		EdgePartition;
-typedef std::tuple<PointsList, PointsList>	PointsPartition;
+typedef std::tuple<Edge*, Edge*>			EdgePartition;
+
+//	--------------------------------------------------------
+//	Scratch space for the Voronoi pass
+//	--------------------------------------------------------
+
+// For every QuadEdge: which of its two sides it speaks for (bit 0 for edges[0]'s left face, bit 1 for edges[2]'s),
+// and, once the counts are summed up, the slot in voronoi_verts_ where its first triangle goes
+struct FaceTable
+{
+	std::vector<char>						owned;
+	std::vector<int>						first_face;
+};
+
+// Where a walk through the mesh ended up, relative to the edge it hands back
+enum Location
+{
+	LOCATED_VERTEX,			// On the edge's origin
+	LOCATED_EDGE,			// Strictly inside the edge, which has a triangle on its left
+	LOCATED_FACE,			// Strictly inside the triangle on the edge's left
+	LOCATED_OUTSIDE			// Outside the convex hull; the edge is a hull edge with the point strictly to its right
+};
 
 //	--------------------------------------------------------
 // The class, creatively named, that will house our methods
@@ -42,80 +77,259 @@ class Delaunay
 private:
 	// Components of the graph
 	PointsList								vertices_;
-	QuadList								edges_;
+	EdgeStore								edges_;
+
+	// The Verts live in here (and the QuadEdges in the edge store), so everything goes away with the Delaunay object
+	Pool<Vert>								vert_pool_;
+
+	// The Voronoi vertices, one per triangle and shared by the duals of its three sides, allocated in one go
+	std::vector<Vert>						voronoi_verts_;
+
+	// Extra edge stores for subtrees forked off during a parallel triangulation, folded back into edges_ at the end
+	std::vector<std::unique_ptr<EdgeStore>>	forked_stores_;
+	std::mutex								forked_lock_;
+	int										parallel_cutoff_;
+	EdgeStore&								ForkStore();
+
+	// Where each vertex came from in the caller's input, by position in vertices_
+	std::vector<int>						sources_;
+
+	// Walks start from wherever the last one finished, or from the grid, whichever is closer
+	Edge*									hint_;
+	PointLocator							locator_;
+	Edge*									StartEdge(Vert* p);
+
+	// Voronoi vertices for duals patched up after GetVoronoi, so they don't have to fit in voronoi_verts_
+	Pool<Vert>								dual_pool_;
+	bool									voronoi_live_;
 
 	// Helper to create a bunch of random vertices
 	void									GenerateRandomVerts(int n);
 
-	// Helper to cut the array of points in half
-	PointsPartition							SplitPoints(const PointsList& points);
+	// Helper to sort, dedupe and adopt a caller's (x, y) records
+	// The sort keys and record order are kept around, so loading again (see Retriangulate) doesn't allocate them again
+	void									LoadPoints(const Coord* xy, int count);
+	std::vector<uint64_t>					sort_keys_;
+	std::vector<uint32_t>					sort_order_;
+
+	// Helper to cut a range of the array of points in half
+	int										SplitPoints(int begin, int end);
 
 	// Functions that create or remove edges
-	Edge*									MakeEdgeBetween(int a, int b, const PointsList& points);
-	Edge*									Connect(Edge* a, Edge* b);
+	Edge*									MakeEdgeBetween(int a, int b, const PointsList& points, EdgeStore& store);
+	Edge*									Connect(Edge* a, Edge* b, EdgeStore& store);
 	void									Kill(Edge* edge);
 
 	// Functions for generating primitive shapes that we'll merge together
-	EdgePartition							LinePrimitive(const PointsList& points);
-	EdgePartition							TrianglePrimitive(const PointsList& points);
+	EdgePartition							LinePrimitive(const PointsList& points, int begin, EdgeStore& store);
+	EdgePartition							TrianglePrimitive(const PointsList& points, int begin, EdgeStore& store);
 
 	// Refactored subroutines to make the big algorithm more readable
-	Edge*									LowestCommonTangent(Edge*& left_inner, Edge*& right_inner);
+	Edge*									LowestCommonTangent(Edge*& left_inner, Edge*& right_inner, EdgeStore& store);
 	Edge*									LeftCandidate(Edge* base_edge);
 	Edge*									RightCandidate(Edge* base_edge);
-	void									MergeHulls(Edge*& base_edge);
+	void									MergeHulls(Edge*& base_edge, EdgeStore& store);
+	EdgePartition							Merge(EdgePartition left, EdgePartition right, EdgeStore& store);
+
+	// The Voronoi pass, in three sweeps over edges_.quads that can each run in chunks side by side:
+	// count the triangles each quad speaks for, compute and hand out their circumcenters, then hide the duals that run off to infinity
+	bool									OwnsFace(Edge* e);
+	void									ClearDuals(int begin, int end);
+	void									CountFaces(int begin, int end, FaceTable& faces);
+	void									VoronoiRange(int begin, int end, FaceTable& faces);
+	void									TrimDuals(int begin, int end);
+
+	// Writes the vertex ids of the triangles edges_.quads[begin, end) speak for, three per triangle, from slot first_face[begin] on
+	void									TriangleRange(int begin, int end, FaceTable& faces, int* indices);
+
+	// Pieces of Insert
+	Location								Walk(Vert* p, Edge*& e);
+	void									Swap(Edge* e);
+	void									InsertInFace(Vert* v, Edge* e);
+	void									InsertOnEdge(Vert* v, Edge* e);
+	void									InsertOutside(Vert* v, Edge* e);
+	void									RestoreDelaunay(Vert* v);
+	void									Rebuild();
+
+	// Pieces of Remove
+	void									FillHole(Vert* v, EdgeList& boundary, bool closed, EdgeList& made);
+	void									DropVertex(Vert* v);
+	void									CutOut(Vert* v, EdgeList& links, EdgeList& made);
+
+	// Pieces of Move
+	Edge*									OutsideSpoke(Vert* v);
+	bool									StarValid(Vert* v, Edge* gap);
+	bool									FillDents(PointsList& hull, EdgeList& made);
+	void									Legalize(EdgeList& suspects, EdgeList& flipped);
+	bool									ShiftVertex(Vert* v, Coord x, Coord y);
+	bool									Relocate(Vert* v, Coord x, Coord y);
+	void									SeparateMoved(const PointsList& moved, const std::vector<Coord>& old);
+
+	// Pieces of GetRaster
+	void									CollectFaces(EdgeList& faces, PointsList& corners, TaskPool* tasks);
+	bool									FaceCells(const RasterGrid& grid, Vert* const* corners, int& first_column, int& last_column, int& first_row, int& last_row);
+	void									RasterFace(Edge* face, Vert* const* corners, const float* values, RasterGrid& grid, RasterMode mode, int tile_x, int tile_y, EdgeList& cavity, EdgeList& stack);
+	Edge*									FaceKey(Edge* e);
+	void									NaturalNeighbour(Edge* face, double x, double y, const float* values, EdgeList& cavity, EdgeList& stack, double& value);
+
+	// Recompute the duals of one edge's QuadEdge, or of every edge touching the triangles around v
+	void									UpdateDual(Edge* e);
+	void									UpdateDualsAround(Vert* v);
+	void									ReleaseDual(Vert* dual);
 
 	// The main attraction
-	EdgePartition							Triangulate(const PointsList& points);
+	// New edges go into store; with a task pool, ranges bigger than parallel_cutoff_ fork their left half
+	EdgePartition							Triangulate(int begin, int end, EdgeStore& store, TaskPool* tasks);
+
+	// Dwyer's variant: cut across x and y in turn, on a scratch copy of the vertex list, so the pieces come out roughly square
+	// axis 0 cuts by (x, y) and axis 1 by (y, -x); the latter is just the plane turned a quarter, so the predicates don't care
+	bool									alternate_cuts_;
+	PointsList								cuts_;
+	EdgePartition							TriangulateAlternating(int begin, int end, int axis, EdgeStore& store, TaskPool* tasks);
+	EdgePartition							HullExtremes(Edge* hull_edge, int axis);
+	EdgePartition							TriangulateAll(TaskPool* tasks);
+
+	// Triangulate the vertices on this thread, leaving the edges in edges_
+	void									BuildTriangulation();
+
+	// Splits [0, count) into chunks and runs work on each, on the pool if there is one
+	void									RunChunks(TaskPool* tasks, int count, const std::function<void(int, int)>& work);
 
 public:
-	// Constructor
+	// Constructors: n random points, or count packed (x, y) records (read in place, e.g. out of a memory-mapped file)
 	Delaunay(int n);
+	Delaunay(const Coord* xy, int count);
+
+	// The vertices, in sorted order until something gets inserted or removed; vertex i has id() i
+	const PointsList&						GetVertices()							{ return vertices_; };
+
+	// For each vertex, in sorted order, the index of the input record it came from
+	// Inserted vertices go on the end, out of order, with -1 since they didn't come from any record
+	const std::vector<int>&					GetSources()							{ return sources_; };
+
+	// The current edges, without triangulating again
+	const QuadList&							GetQuads()								{ return edges_.quads; };
+
+	// True if the face on e's left is a real triangle rather than the outside of the hull
+	static bool								IsTriangle(Edge* e);
 
 	// Triangulate the vertices
 	QuadList								GetTriangulation();
+
+	// Same, but spread across threads; ranges smaller than cutoff are done sequentially
+	QuadList								GetTriangulation(int threads, int cutoff = 1 << 16);
+
+	// Throw everything away and triangulate count new (x, y) records instead, as if freshly constructed
+	// The pools keep their blocks and the lists their capacity, so doing this over and over with small sets hardly allocates at all
+	// Hands back the edges by reference rather than copying them out like GetTriangulation
+	const QuadList&							Retriangulate(const Coord* xy, int count);
+
+	// Have both of the above alternate vertical and horizontal cuts instead of always cutting by x
+	void									SetAlternatingCuts(bool alternate)		{ alternate_cuts_ = alternate; };
 	
-	// Build the Voronoi diagram corresponding to the triangulation
-	QuadList								GetVoronoi();
+	// Build the Voronoi diagram corresponding to the triangulation, optionally across threads
+	QuadList								GetVoronoi(int threads = 1);
+
+	// Build the Euclidean minimum spanning tree across the vertices, sorting the edges across threads if asked
+	// It's always a subset of the Delaunay edges, so triangulate first
+	EdgeList								GetMST(int threads = 1);
+
+	// Copy the triangulation into the compact index-based store; vertex i there is the ith sorted vertex here
+	void									GetCompactMesh(CompactMesh& mesh);
+
+	// Export the vertex adjacency as compressed sparse rows, optionally with edge lengths, optionally across threads
+	void									GetAdjacency(AdjacencyGraph& graph, bool lengths = false, int threads = 1);
+
+	// Export the triangles as a flat index buffer: vertex ids (i, j, k), counterclockwise, each triangle exactly once
+	// indices gets resized to fit, so hanging on to it between calls saves the allocation; threads > 1 splits the work up
+	void									GetTriangles(std::vector<int>& indices, int threads = 1);
+
+	// Interpolate values (one per vertex, by id; see GetSources to get there from the input records) onto every cell of grid a triangle covers
+	// Each triangle is scanned row by row with its barycentric coordinates stepped along, so no cell needs a point location
+	// RASTER_NATURAL uses Sibson's weights instead, found from the triangle each cell is in; threads > 1 splits the grid into tiles
+	void									GetRaster(const float* values, RasterGrid& grid, RasterMode mode = RASTER_LINEAR, int threads = 1);
+
+	// Find where (x, y) lands in the triangulation; see Location for what the returned edge means
+	// nullptr if there's no triangle to be in yet (fewer than three points, or all of them collinear) or the point isn't finite
+	Edge*									Locate(Coord x, Coord y, Location& where);
 
-	// Build a minimum spanning tree across the vertices
-	EdgeList								GetMST();
+	// The vertex closest to (x, y), or nullptr if there aren't any
+	Vert*									Nearest(Coord x, Coord y);
+
+	// The same for count packed (x, y) queries; each walk starts where the last one stopped, so nearby queries in a row are cheap
+	void									Locate(const Coord* xy, int count, EdgeList& edges, std::vector<Location>& where);
+	void									Nearest(const Coord* xy, int count, PointsList& verts);
+
+	// Add a point to the existing triangulation, retriangulating only around it (and patching the duals, if GetVoronoi has run)
+	// Returns the new vertex, the existing one if the point is already there, or nullptr if it isn't a finite number
+	// Don't call GetTriangulation again afterwards; use GetQuads
+	Vert*									Insert(Coord x, Coord y);
+
+	// Take a vertex out, retriangulating only the hole it leaves; returns false if v isn't one of ours
+	// The last vertex in the list takes over v's id
+	bool									Remove(Vert* v);
+
+	// Move existing vertices, xy holding one packed (x, y) record per entry of verts, and repair the mesh locally around each one
+	// Small steps just need flips; a step that would turn a triangle inside out cuts the vertex out and inserts it again, same Vert and id
+	// Only a mesh that's down to a line (or nothing) gets rebuilt, which renumbers the vertices like Insert does early on; returns false then
+	// Anything that isn't ours or isn't finite stays put, and so does a vertex that would land on another
+	bool									Move(const PointsList& verts, const Coord* xy);
 };
 
 //	--------------------------------------------------------
 //	Constructor
 //	--------------------------------------------------------
 
-Delaunay::Delaunay(int n)
+Delaunay::Delaunay(int n) : parallel_cutoff_(0), hint_(nullptr), voronoi_live_(false), alternate_cuts_(false)
 {
 	// For the moment, we generate the vertices
-	edges_ = QuadList();
 	GenerateRandomVerts(n);
 }
 
+Delaunay::Delaunay(const Coord* xy, int count) : parallel_cutoff_(0), hint_(nullptr), voronoi_live_(false), alternate_cuts_(false)
+{
+	LoadPoints(xy, count);
+}
+
 void Delaunay::GenerateRandomVerts(int n)
 {
 	// Generate a field of random vertices for debug/demonstration
 
 	srand(time(NULL));
 
-	std::vector<std::vector<int>> buffer;
-
-	// Build a buffer list
-	for (int i = 0; i < n; i++)
+	// Build a flat buffer of (x, y) records, then sort and dedupe it like anybody else's points
+	std::vector<Coord> buffer(2 * n);
+	for (int i = 0; i < 2 * n; i++)
 	{
-		std::vector<int> xy = { rand() % 512, rand() % 512 };
-		buffer.push_back(xy);
+		buffer[i] = rand() % 512;
 	}
 
-	// Sort it lexicographically; we need this step
-	std::sort(buffer.begin(), buffer.end());
-	buffer.erase(std::unique(buffer.begin(), buffer.end()), buffer.end());
+	LoadPoints(buffer.data(), n);
+}
 
-	// Turn it into Verts for the convenience of our algorithm
-	for (int i = 0; i < buffer.size(); i++)
+void Delaunay::LoadPoints(const Coord* xy, int count)
+{
+	// Sort keys and record indices rather than the records, so the coordinates only ever get read where they sit
+	// Lexicographically, that is; we need this step (see presort.h)
+	std::vector<uint64_t>& keys = sort_keys_;
+	std::vector<uint32_t>& order = sort_order_;
+	SortPoints(xy, count, keys, order);
+
+	// Make a Vert for the first record of every run of duplicates, which all have the same key
+	vertices_.reserve(order.size());
+	sources_.reserve(order.size());
+	for (int i = 0; i < order.size(); i++)
 	{
-		vertices_.push_back(new Vert(buffer[i][0], buffer[i][1]));
+		if (i > 0 && keys[i] == keys[i - 1])
+		{
+			continue;
+		}
+
+		const Coord* p = xy + 2 * order[i];
+
+		vertices_.push_back(vert_pool_.Make(p[0], p[1]));
+		vertices_.back()->setId(vertices_.size() - 1);
+		sources_.push_back(order[i]);
 	}
 }
 
@@ -125,38 +339,62 @@ void Delaunay::GenerateRandomVerts(int n)
 
 void Delaunay::Kill(Edge* edge)
 {
+	COUNT_CALL(COUNT_KILL);
+
+	// The slot is about to be recycled, so make sure neither endpoint still thinks it owns this edge
+	Vert* org = edge->origin();
+	Vert* dest = edge->destination();
+	if (org->edge() == edge)
+	{
+		org->AddEdge((edge->Onext() != edge) ? edge->Onext() : nullptr);
+	}
+	if (dest->edge() == edge->Sym())
+	{
+		dest->AddEdge((edge->Sym()->Onext() != edge->Sym()) ? edge->Sym()->Onext() : nullptr);
+	}
+
 	// Fix the local mesh
 	Splice(edge, edge->Oprev());
 	Splice(edge->Sym(), edge->Sym()->Oprev());
 
-	// Free the quad edge that the edge belongs to
+	// Hand the quad edge that the edge belongs to back to whichever store it came from
+	// Its duals go too, and the next walk can't start from it
 	QuadEdge* raw = (QuadEdge*)(edge - (edge->index()));
-	edges_.erase(std::remove(edges_.begin(), edges_.end(), raw));
-	delete raw;
+	ReleaseDual(raw->edges[1].origin());
+	ReleaseDual(raw->edges[3].origin());
+	if (hint_ != nullptr && hint_ - hint_->index() == raw->edges)
+	{
+		hint_ = nullptr;
+	}
+	raw->store->Release(raw);
+}
+
+EdgeStore& Delaunay::ForkStore()
+{
+	// Called from any thread that's about to fork, hence the lock
+	std::lock_guard<std::mutex> guard(forked_lock_);
+	forked_stores_.push_back(std::unique_ptr<EdgeStore>(new EdgeStore()));
+	return *forked_stores_.back();
 }
 
 //	--------------------------------------------------------
 //	Helper functions
 //	--------------------------------------------------------
 
-// Split the list of vertices in the center
+// Split the range [begin, end) of vertices in the center and return where the right half starts
 // Thsi relies on the assumption that they're ordered lexicographically
-PointsPartition Delaunay::SplitPoints(const PointsList& points)
+// Nothing gets copied; both halves keep pointing into vertices_
+int Delaunay::SplitPoints(int begin, int end)
 {
-	int halfway = (points.size() / 2);
-
-	PointsList left(points.begin(), points.begin() + halfway);
-	PointsList right(points.begin() + halfway, points.end());
-
-	return PointsPartition(left, right);
+	return begin + (end - begin) / 2;
 }
 
 // Creates an edge between the vertices at the given indices
 // This is accomplished by creating a new QuadEdge, setting its 0th edge to originate at points[a] and setting its 2nd edge to originate at points[b]
-Edge* Delaunay::MakeEdgeBetween(int a, int b, const PointsList& points)
+Edge* Delaunay::MakeEdgeBetween(int a, int b, const PointsList& points, EdgeStore& store)
 {
 	// Create the QuadEdge and return the memory address of its 0th edge
-	Edge* e = Edge::Make(edges_);
+	Edge* e = Edge::Make(store);
 	
 	// Set it to originate from the Vert at index a
 	e->setOrigin(points[a]);
@@ -170,12 +408,13 @@ Edge* Delaunay::MakeEdgeBetween(int a, int b, const PointsList& points)
 }
 
 // Connects the ends of two edges to form a coherently oriented triangle
-Edge* Delaunay::Connect(Edge* a, Edge* b)
+Edge* Delaunay::Connect(Edge* a, Edge* b, EdgeStore& store)
 {
 	// See Guibas and Stolfi for more
+	COUNT_CALL(COUNT_CONNECT);
 
 	// Create a new QuadEdge and return the memory address of its 0th edge
-	Edge* e = Edge::Make(edges_);
+	Edge* e = Edge::Make(store);
 
 	// Set it to originate at the end point of b
 	e->setOrigin(a->destination());
@@ -191,45 +430,49 @@ Edge* Delaunay::Connect(Edge* a, Edge* b)
 	return e;
 }
 
-// Connects two vertices into an edge
-EdgePartition Delaunay::LinePrimitive(const PointsList& points)
+// Connects the two vertices starting at begin into an edge
+EdgePartition Delaunay::LinePrimitive(const PointsList& points, int begin, EdgeStore& store)
 {
 	// Build a line primitive
 	// And return it twice?
-	Edge* e = MakeEdgeBetween(0, 1, points);
+	Edge* e = MakeEdgeBetween(begin, begin + 1, points, store);
 	Edge* e_sym = e->Sym();
-	return EdgePartition({ e }, { e_sym });
+	return EdgePartition(e, e_sym);
 }
 
-// Connects three vertices into a coherently oriented triangle
-EdgePartition Delaunay::TrianglePrimitive(const PointsList& points)
+// Connects the three vertices starting at begin into a coherently oriented triangle
+EdgePartition Delaunay::TrianglePrimitive(const PointsList& points, int begin, EdgeStore& store)
 {
+	Vert* p0 = points[begin];
+	Vert* p1 = points[begin + 1];
+	Vert* p2 = points[begin + 2];
+
 	// Build our first two edges here
-	Edge* a = MakeEdgeBetween(0, 1, points);
-	Edge* b = MakeEdgeBetween(1, 2, points);
+	Edge* a = MakeEdgeBetween(begin, begin + 1, points, store);
+	Edge* b = MakeEdgeBetween(begin + 1, begin + 2, points, store);
 
 	// Do the splice thing; I'm not sure why
 	Splice(a->Sym(), b);
 
 	// We want a consistent face orientation, so determine which way we're going here
-	if (CCW(points[0], points[1], points[2]))
+	if (CCW(p0, p1, p2))
 	{
-		Edge* c = Connect(b, a);
-		return EdgePartition({ a }, { b->Sym() });
+		Edge* c = Connect(b, a, store);
+		return EdgePartition(a, b->Sym());
 	}
-	else if (CCW(points[0], points[2], points[1]))
+	else if (CCW(p0, p2, p1))
 	{
-		Edge* c = Connect(b, a);
-		return EdgePartition({ c->Sym() }, { c });
+		Edge* c = Connect(b, a, store);
+		return EdgePartition(c->Sym(), c);
 	}
 	else
 	{
 		// The points are collinear
-		return EdgePartition({ a }, { b->Sym() });
+		return EdgePartition(a, b->Sym());
 	}
 }
 
-Edge* Delaunay::LowestCommonTangent(Edge*& left_inner, Edge*& right_inner)
+Edge* Delaunay::LowestCommonTangent(Edge*& left_inner, Edge*& right_inner, EdgeStore& store)
 {
 	// Compute the lower common tangent of the two halves
 	// Note the pointer references; we want to keep track of where the new inner edges end up
@@ -237,6 +480,7 @@ Edge* Delaunay::LowestCommonTangent(Edge*& left_inner, Edge*& right_inner)
 	// Until we can't do it anymore, take turns rotating along the hulls of the two shapes we're connecting
 	while (true)
 	{
+		COUNT_TANGENT_STEP();
 		if (LeftOf(left_inner, right_inner->origin()))
 		{
 			left_inner = left_inner->Lnext();
@@ -252,7 +496,7 @@ Edge* Delaunay::LowestCommonTangent(Edge*& left_inner, Edge*& right_inner)
 	}
 
 	// Create the base edge once we hit the bottom
-	Edge* base_edge = Connect(right_inner->Sym(), left_inner);
+	Edge* base_edge = Connect(right_inner->Sym(), left_inner, store);
 	return base_edge;
 }
 
@@ -267,6 +511,7 @@ Edge* Delaunay::LeftCandidate(Edge* base_edge)
 		{
 			Edge* t = left_candidate->Onext();
 			Kill(left_candidate);
+			COUNT_MERGE_KILL();
 			left_candidate = t;
 		}
 	}
@@ -285,6 +530,7 @@ Edge* Delaunay::RightCandidate(Edge* base_edge)
 		{
 			Edge* t = right_candidate->Oprev();
 			Kill(right_candidate);
+			COUNT_MERGE_KILL();
 			right_candidate = t;
 		}
 	}
@@ -292,7 +538,7 @@ Edge* Delaunay::RightCandidate(Edge* base_edge)
 	return right_candidate;
 }
 
-void Delaunay::MergeHulls(Edge*& base_edge)
+void Delaunay::MergeHulls(Edge*& base_edge, EdgeStore& store)
 {
 	// Zip up the two halves of the hull once we've found the base edge
 	while (true)
@@ -311,12 +557,12 @@ void Delaunay::MergeHulls(Edge*& base_edge)
 		{
 			// Otherwise, if we can rule out the left guy, connect the right edge to the base and set the new base edge
 			// This ruling out comes either from creating an invalid hypothetical triangle or from being beneath the base edge
-			base_edge = Connect(right_candidate, base_edge->Sym());
+			base_edge = Connect(right_candidate, base_edge->Sym(), store);
 		}
 		else
 		{
 			// If we can't do that, then the left edge must be valid and we connect it to the base and set the new base edge
-			base_edge = Connect(base_edge->Sym(), left_candidate->Sym());
+			base_edge = Connect(base_edge->Sym(), left_candidate->Sym(), store);
 		}
 	}
 }
@@ -325,44 +571,70 @@ void Delaunay::MergeHulls(Edge*& base_edge)
 //	The main attraction
 //	--------------------------------------------------------
 
-EdgePartition Delaunay::Triangulate(const PointsList& points)
+EdgePartition Delaunay::Triangulate(int begin, int end, EdgeStore& store, TaskPool* tasks)
 {
-	// Returns the left and right hulls created by triangulating
+	// Returns the left and right hulls created by triangulating the vertices in [begin, end)
 	// The ultimate value we care about is actually the edges_ member of the Delaunay class
 	// This is recursive because divide-and-conquer is a good way to do this
 	// See Guibas and Stolfi
 
 	// (Also, we have to assume that the point set we're given is sorted lexicographically)
+	COUNT_ENTER_LEVEL();
 
 	/* Terminal cases */
 	
-	if (points.size() == 2)
+	if (end - begin == 2)
 	{
-		return LinePrimitive(points);
+		return LinePrimitive(vertices_, begin, store);
 	}
-	if (points.size() == 3)
+	if (end - begin == 3)
 	{
-		return TrianglePrimitive(points);
+		return TrianglePrimitive(vertices_, begin, store);
 	}
 
 	// Once we survive the terminal-case filter, split up the points
-	PointsPartition partition = SplitPoints(points);
+	int halfway = SplitPoints(begin, end);
 
-	EdgePartition left = Triangulate(std::get<0>(partition));
-	EdgePartition right = Triangulate(std::get<1>(partition));
+	EdgePartition left;
+	EdgePartition right;
 
-	/* This part of the code is only reachable once we terminate, at which point the vectors are singleton sets */
-	
+	if (tasks != nullptr && end - begin > parallel_cutoff_)
+	{
+		// The halves don't touch each other until the merge, so hand the left one to the pool with its own edge store
+		// Whoever picks it up can make edges without stepping on us, and we carry on with the right half meanwhile
+		EdgeStore& left_store = ForkStore();
+		COUNT_SAVE_LEVEL(level);
+		Task left_task([&]() { COUNT_RESTORE_LEVEL(level); left = Triangulate(begin, halfway, left_store, tasks); });
+		tasks->Fork(left_task);
+		right = Triangulate(halfway, end, store, tasks);
+		tasks->Join(left_task);
+	}
+	else
+	{
+		left = Triangulate(begin, halfway, store, tasks);
+		right = Triangulate(halfway, end, store, tasks);
+	}
+
+	/* This part of the code is only reachable once we terminate, at which point each half hands back a pair of hull edges */
+	return Merge(left, right, store);
+}
+
+// Stitches two triangulated halves together
+// Each half comes as its pair of outer hull edges: the counterclockwise one out of its leftmost vertex and the clockwise one out of its rightmost
+// "Left" and "right" only have to hold along whatever axis the halves were cut on; nothing below looks at coordinates except through the predicates
+EdgePartition Delaunay::Merge(EdgePartition left, EdgePartition right, EdgeStore& store)
+{
 	// Get the inner "inner" edges
-	Edge* right_inner = std::get<0>(right)[0];
-	Edge* left_inner = std::get<1>(left)[0];
+	Edge* right_inner = std::get<0>(right);
+	Edge* left_inner = std::get<1>(left);
 
 	// Get the initial "outer" edges
-	Edge* left_outer = std::get<0>(left)[0];
-	Edge* right_outer = std::get<1>(right)[0];
+	Edge* left_outer = std::get<0>(left);
+	Edge* right_outer = std::get<1>(right);
 
 	// Get the lowest common tangent from our initial inner edges
-	Edge* base_edge = LowestCommonTangent(left_inner, right_inner);
+	COUNT_MERGE();
+	Edge* base_edge = LowestCommonTangent(left_inner, right_inner, store);
 
 	// Correct the base edge
 	if (left_inner->origin() == left_outer->origin())
@@ -376,79 +648,1930 @@ EdgePartition Delaunay::Triangulate(const PointsList& points)
 
 	// Finish the merge operation by "zipping up the gap"
 	// i.e. connect things if they don't violate the Delaunay criterion
-	MergeHulls(base_edge);
+	MergeHulls(base_edge, store);
 
 	// Return the outer edges, because they'll be the new inner edges when we do a higher-level merge
-	return EdgePartition({ left_outer }, { right_outer });
+	return EdgePartition(left_outer, right_outer);
 }
 
-QuadList Delaunay::GetTriangulation()
+// Orders vertices along a cut axis: (x, y) lexicographically for axis 0, (y, -x) for axis 1
+struct AxisLess
+{
+	int axis;
+
+	AxisLess(int a) : axis(a) {};
+
+	bool operator()(Vert* a, Vert* b) const
+	{
+		if (axis == 0)
+		{
+			return (a->x() < b->x()) || (a->x() == b->x() && a->y() < b->y());
+		}
+		return (a->y() < b->y()) || (a->y() == b->y() && a->x() > b->x());
+	}
+};
+
+EdgePartition Delaunay::TriangulateAlternating(int begin, int end, int axis, EdgeStore& store, TaskPool* tasks)
+{
+	// Same recursion as Triangulate, except each level cuts cuts_[begin, end) at its median along this level's axis
+	// and hands the other axis down, so every piece stays roughly square instead of turning into a thin vertical strip
+	COUNT_ENTER_LEVEL();
+
+	/* Terminal cases */
+
+	// The primitives want their points in order, but any axis will do for that
+	if (end - begin <= 3)
+	{
+		std::sort(cuts_.begin() + begin, cuts_.begin() + end, AxisLess(axis));
+		return (end - begin == 2) ? LinePrimitive(cuts_, begin, store) : TrianglePrimitive(cuts_, begin, store);
+	}
+
+	// Nothing to sort here; the median is enough, and it leaves everything below it on the left
+	int halfway = begin + (end - begin) / 2;
+	std::nth_element(cuts_.begin() + begin, cuts_.begin() + halfway, cuts_.begin() + end, AxisLess(axis));
+
+	EdgePartition left;
+	EdgePartition right;
+
+	if (tasks != nullptr && end - begin > parallel_cutoff_)
+	{
+		EdgeStore& left_store = ForkStore();
+		COUNT_SAVE_LEVEL(level);
+		Task left_task([&]() { COUNT_RESTORE_LEVEL(level); left = TriangulateAlternating(begin, halfway, 1 - axis, left_store, tasks); });
+		tasks->Fork(left_task);
+		right = TriangulateAlternating(halfway, end, 1 - axis, store, tasks);
+		tasks->Join(left_task);
+	}
+	else
+	{
+		left = TriangulateAlternating(begin, halfway, 1 - axis, store, tasks);
+		right = TriangulateAlternating(halfway, end, 1 - axis, store, tasks);
+	}
+
+	// The halves handed back their extremes along the other axis, so find the ones along ours before merging
+	return Merge(HullExtremes(std::get<0>(left), axis), HullExtremes(std::get<0>(right), axis), store);
+}
+
+// Walks all the way around a hull, starting from a counterclockwise hull edge, and returns the outer edge pair Merge wants along the given axis
+// For reasonably spread-out points a hull is short, so this costs far less than the merge it sets up
+// (A hull that's just a line gets walked out and back, which still finds both ends)
+EdgePartition Delaunay::HullExtremes(Edge* hull_edge, int axis)
+{
+	AxisLess less(axis);
+	Edge* low = hull_edge;
+	Edge* high = hull_edge;
+
+	Edge* e = hull_edge;
+	do
+	{
+		// low leaves the lowest vertex, high arrives at the highest
+		if (less(e->origin(), low->origin()))
+		{
+			low = e;
+		}
+		if (less(high->destination(), e->destination()))
+		{
+			high = e;
+		}
+		e = e->Rprev();
+	} while (e != hull_edge);
+
+	return EdgePartition(low, high->Sym());
+}
+
+EdgePartition Delaunay::TriangulateAll(TaskPool* tasks)
+{
+	if (!alternate_cuts_)
+	{
+		return Triangulate(0, vertices_.size(), edges_, tasks);
+	}
+
+	// The cuts get shuffled around in a copy, so vertices_ stays sorted and every id still means what it did
+	cuts_ = vertices_;
+	EdgePartition result = TriangulateAlternating(0, cuts_.size(), 0, edges_, tasks);
+	PointsList().swap(cuts_);
+	return result;
+}
+
+void Delaunay::BuildTriangulation()
 {
 	// Wrapper for the triangulation function
 	// This should make it less confusing to call Triangulate with the right vertex list
-	EdgePartition tuple = Triangulate(vertices_);
-	return edges_;
+	if (vertices_.size() < 2)
+	{
+		return;
+	}
+
+	// A planar triangulation has fewer than 3n edges, so this is the only time the list needs to grow
+	edges_.quads.reserve(3 * vertices_.size());
+
+	TriangulateAll(nullptr);
+}
+
+QuadList Delaunay::GetTriangulation()
+{
+	BuildTriangulation();
+	return edges_.quads;
+}
+
+const QuadList& Delaunay::Retriangulate(const Coord* xy, int count)
+{
+	// Back to a blank slate, except for the memory
+	vertices_.clear();
+	sources_.clear();
+	edges_.Reset();
+	vert_pool_.Reset();
+	dual_pool_.Reset();
+	voronoi_verts_.clear();
+	voronoi_live_ = false;
+	forked_stores_.clear();
+	hint_ = nullptr;
+	locator_.Clear();
+
+	LoadPoints(xy, count);
+	BuildTriangulation();
+	return edges_.quads;
+}
+
+QuadList Delaunay::GetTriangulation(int threads, int cutoff)
+{
+	// Not worth spinning up threads for something that small
+	if (threads <= 1 || vertices_.size() <= cutoff)
+	{
+		return GetTriangulation();
+	}
+
+	// Don't bother forking anything smaller than a few primitives
+	parallel_cutoff_ = std::max(cutoff, 4);
+
+	TaskPool tasks(threads);
+	TriangulateAll(&tasks);
+
+	// Work out where each forked store's QuadEdges will land in ours
+	std::vector<int> offsets;
+	int total = edges_.quads.size();
+	for (auto i = forked_stores_.begin(); i != forked_stores_.end(); i++)
+	{
+		offsets.push_back(total);
+		total += (*i)->quads.size();
+		edges_.pool.Adopt((*i)->pool);
+	}
+	edges_.quads.resize(total);
+
+	// Then fold them all back in side by side, so everything downstream sees a single edge list again
+	std::vector<std::unique_ptr<Task>> moves;
+	for (int i = 0; i < forked_stores_.size(); i++)
+	{
+		EdgeStore* forked = forked_stores_[i].get();
+		int offset = offsets[i];
+		moves.push_back(std::unique_ptr<Task>(new Task([this, forked, offset]() { edges_.Absorb(*forked, offset); })));
+		tasks.Fork(*moves.back());
+	}
+	for (auto i = moves.begin(); i != moves.end(); i++)
+	{
+		tasks.Join(**i);
+	}
+
+	forked_stores_.clear();
+	return edges_.quads;
+}
+
+// True if e's left face is a real triangle and e is the side that speaks for it: the one with the lowest address
+// That gives every triangle exactly one owner, which chunks of quads can agree on without talking to each other
+bool Delaunay::OwnsFace(Edge* e)
+{
+	// Cheapest tests first: two sides out of three bail after a single step round the face
+	Edge* next = e->Lnext();
+	if (!std::less<Edge*>()(e, next))
+	{
+		return false;
+	}
+	Edge* prev = next->Lnext();
+	return std::less<Edge*>()(e, prev) && prev->Lnext() == e && CCW(e->origin(), e->destination(), next->destination());
+}
+
+void Delaunay::ClearDuals(int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		edges_.quads[i]->edges[1].clearOrigin();
+		edges_.quads[i]->edges[3].clearOrigin();
+	}
 }
 
-QuadList Delaunay::GetVoronoi()
+void Delaunay::CountFaces(int begin, int end, FaceTable& faces)
 {
-	for (auto i = edges_.begin(); i != edges_.end(); i++)
+	for (int i = begin; i < end; i++)
 	{
-		Edge* e = (*i)->edges;
+		Edge* e = edges_.quads[i]->edges;
+		faces.owned[i] = (OwnsFace(&e[0]) ? 1 : 0) | (OwnsFace(&e[2]) ? 2 : 0);
+		faces.first_face[i + 1] = (faces.owned[i] & 1) + (faces.owned[i] >> 1);
+	}
+}
 
-		// If we're not on the exterior
-		if (CCW(e[0].origin(), e[0].destination(), e[0].Onext()->destination())
-			&& CCW(e[0].origin(), e[0].Oprev()->destination(), e[0].destination()))
+void Delaunay::VoronoiRange(int begin, int end, FaceTable& faces)
+{
+	// This chunk owns triangle slots [first_face[begin], first_face[end]) of voronoi_verts_
+	int k = faces.first_face[begin];
+	for (int i = begin; i < end; i++)
+	{
+		Edge* e = edges_.quads[i]->edges;
+		for (int side = 0; side < 2; side++)
 		{
-			e[1].setOrigin(Circumcenter(e[0].origin(), e[0].destination(), e[0].Onext()->destination()));
-			e[3].setOrigin(Circumcenter(e[0].origin(), e[0].Oprev()->destination(), e[0].destination()));
+			if (faces.owned[i] & (1 << side))
+			{
+				Edge* s = &e[2 * side];
+				Edge* next = s->Lnext();
+				Edge* prev = next->Lnext();
+
+				double x, y;
+				Vert* a = s->origin();
+				Vert* b = next->origin();
+				Vert* c = prev->origin();
+				Circumcenter(a->x(), a->y(), b->x(), b->y(), c->x(), c->y(), x, y);
+				voronoi_verts_[k] = Vert(CoordFromDouble(x), CoordFromDouble(y));
+
+				// Hand it to the duals of all three sides; see Guibas and Stolfi, e->InvRot() starts in e's left face
+				// Every dual edge has exactly one left-hand triangle, so no two chunks ever write the same one
+				s->InvRot()->setOrigin(&voronoi_verts_[k]);
+				next->InvRot()->setOrigin(&voronoi_verts_[k]);
+				prev->InvRot()->setOrigin(&voronoi_verts_[k]);
+				k++;
+			}
 		}
 	}
+}
+
+void Delaunay::TrimDuals(int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		Edge* e = edges_.quads[i]->edges;
 
-	return edges_;
+		// If we're on the exterior, the dual runs off to infinity, so there's nothing to draw
+		if (e[1].origin() == nullptr || e[3].origin() == nullptr)
+		{
+			e[1].clearOrigin();
+			e[3].clearOrigin();
+		}
+	}
 }
 
-EdgeList Delaunay::GetMST()
+QuadList Delaunay::GetVoronoi(int threads)
 {
-	// Okay, so we're not weighting it right now
-	// I can't really think of a reason to
-	EdgeList mst;
-	PointsList queue;
-	std::map<Vert*, int> distance;
+	int count = edges_.quads.size();
+
+	// Every dual gets reassigned below, so anything Insert patched in can go
+	dual_pool_.Clear();
+	voronoi_live_ = true;
+
+	// Each sweep only writes its own quads' slots (or its own triangles' duals), so the list splits cleanly into chunks
+	std::unique_ptr<TaskPool> tasks;
+	if (threads > 1)
+	{
+		tasks.reset(new TaskPool(threads));
+	}
 
-	for (auto i = vertices_.begin(); i != vertices_.end(); i++)
+	FaceTable faces;
+	faces.owned.resize(count);
+	faces.first_face.assign(count + 1, 0);
+	// Nothing from last time survives; the owners fill everything back in on the second sweep
+	RunChunks(tasks.get(), count, [this, &faces](int begin, int end) { ClearDuals(begin, end); CountFaces(begin, end, faces); });
+
+	for (int i = 0; i < count; i++)
 	{
-		distance[*i] = -1;
+		faces.first_face[i + 1] += faces.first_face[i];
 	}
 
-	// So we just do a depth-first search on the linked list
-	Vert* root = vertices_[0];
-	queue.push_back(root);
-	distance[root] = 0;
+	// The Voronoi vertices get allocated once up front, now that we know how many triangles there are
+	voronoi_verts_.assign(faces.first_face[count], Vert(0, 0));
+
+	RunChunks(tasks.get(), count, [this, &faces](int begin, int end) { VoronoiRange(begin, end, faces); });
+	RunChunks(tasks.get(), count, [this](int begin, int end) { TrimDuals(begin, end); });
+
+	return edges_.quads;
+}
 
-	while (queue.size() > 0)
+void Delaunay::TriangleRange(int begin, int end, FaceTable& faces, int* indices)
+{
+	int* out = indices + 3 * faces.first_face[begin];
+	for (int i = begin; i < end; i++)
 	{
-		Vert* current = queue.back();
-		queue.pop_back();
+		Edge* e = edges_.quads[i]->edges;
+		for (int side = 0; side < 2; side++)
+		{
+			if (faces.owned[i] & (1 << side))
+			{
+				// The owner has the triangle on its left, so going round by Lnext is counterclockwise
+				Edge* s = &e[2 * side];
+				Edge* next = s->Lnext();
+				*out++ = s->origin()->id();
+				*out++ = next->origin()->id();
+				*out++ = next->Lnext()->origin()->id();
+			}
+		}
+	}
+}
+
+void Delaunay::GetTriangles(std::vector<int>& indices, int threads)
+{
+	// OwnsFace picks out one side of every triangle, so nothing has to remember which faces it's already seen
+	int count = edges_.quads.size();
+	indices.clear();
 
-		// Check out my syntax skills
-		for (Edge* e = current->edge(); e != current->edge()->Oprev(); e = e->Onext())
+	if (threads <= 1)
+	{
+		// One pass; a triangulation has fewer than two triangles per vertex, so this is the only allocation
+		indices.reserve(6 * vertices_.size());
+		for (int i = 0; i < count; i++)
 		{
-			Vert* dest = e->destination();
-			if (distance[dest] == -1)
+			Edge* e = edges_.quads[i]->edges;
+			for (int side = 0; side < 2; side++)
 			{
-				distance[dest] = distance[current] + 1;
-				queue.push_back(dest);
-				mst.push_back(e);
+				Edge* s = &e[2 * side];
+				if (OwnsFace(s))
+				{
+					Edge* next = s->Lnext();
+					indices.push_back(s->origin()->id());
+					indices.push_back(next->origin()->id());
+					indices.push_back(next->Lnext()->origin()->id());
+				}
 			}
 		}
-	} 
+		return;
+	}
+
+	// Across threads it takes two: count what each quad owns, sum the counts into slots, then have every chunk fill in its own slots
+	TaskPool tasks(threads);
+	FaceTable faces;
+	faces.owned.resize(count);
+	faces.first_face.assign(count + 1, 0);
+	RunChunks(&tasks, count, [this, &faces](int begin, int end) { CountFaces(begin, end, faces); });
+
+	for (int i = 0; i < count; i++)
+	{
+		faces.first_face[i + 1] += faces.first_face[i];
+	}
+
+	indices.resize(3 * faces.first_face[count]);
+	int* data = indices.data();
+	RunChunks(&tasks, count, [this, &faces, data](int begin, int end) { TriangleRange(begin, end, faces, data); });
+}
+
+// A Delaunay edge and its squared length, for Kruskal
+// Ties go by quad index, so the order (and the tree) doesn't depend on how the sort was split up
+struct WeightedEdge
+{
+	double									length;
+	int										quad;
+
+	bool operator<(const WeightedEdge& other) const
+	{
+		return (length < other.length) || (length == other.length && quad < other.quad);
+	}
+};
+
+EdgeList Delaunay::GetMST(int threads)
+{
+	// Kruskal: shortest edges first, keeping every one that joins two trees that weren't joined yet
+	// The Delaunay edges are a planar graph with fewer than 3n edges, which is what keeps this at O(n log n)
+	EdgeList mst;
+	if (vertices_.size() < 2)
+	{
+		return mst;
+	}
 
+	// Endpoint ids go in a flat array on the way past, since chasing the quads again in length order would miss cache every time
+	std::vector<WeightedEdge> weighted(edges_.quads.size());
+	std::vector<int> ends(2 * edges_.quads.size());
+	for (int i = 0; i < edges_.quads.size(); i++)
+	{
+		Edge* e = edges_.quads[i]->edges;
+		weighted[i].length = DistanceSquared(e->origin(), e->destination());
+		weighted[i].quad = i;
+		ends[2 * i] = e->origin()->id();
+		ends[2 * i + 1] = e->destination()->id();
+	}
+
+	if (threads > 1)
+	{
+		TaskPool tasks(threads);
+		ParallelSort(weighted, tasks);
+	}
+	else
+	{
+		std::sort(weighted.begin(), weighted.end());
+	}
 
+	// Vertex ids are already dense, so the forest can just be indexed by them
+	DisjointSets forest(vertices_.size());
+	mst.reserve(vertices_.size() - 1);
+	for (auto i = weighted.begin(); i != weighted.end() && mst.size() + 1 < vertices_.size(); i++)
+	{
+		if (forest.Union(ends[2 * i->quad], ends[2 * i->quad + 1]))
+		{
+			mst.push_back(edges_.quads[i->quad]->edges);
+		}
+	}
 
 	return mst;
 }
 
+void Delaunay::GetCompactMesh(CompactMesh& mesh)
+{
+	mesh.Assign(vertices_, edges_.quads);
+}
+
+void Delaunay::RunChunks(TaskPool* tasks, int count, const std::function<void(int, int)>& work)
+{
+	if (tasks == nullptr)
+	{
+		work(0, count);
+		return;
+	}
+
+	// Same split as GetVoronoi: a few more chunks than threads, so one slow chunk doesn't hold everybody up
+	int chunks = 4 * tasks->size();
+	std::vector<std::unique_ptr<Task>> running;
+	for (int c = 0; c < chunks; c++)
+	{
+		int begin = (long long)count * c / chunks;
+		int end = (long long)count * (c + 1) / chunks;
+		running.push_back(std::unique_ptr<Task>(new Task([&work, begin, end]() { work(begin, end); })));
+		tasks->Fork(*running.back());
+	}
+	for (auto i = running.begin(); i != running.end(); i++)
+	{
+		tasks->Join(**i);
+	}
+}
+
+void Delaunay::GetAdjacency(AdjacencyGraph& graph, bool lengths, int threads)
+{
+	// Two passes over the Onext rings: count every vertex's degree, turn the counts into offsets, then fill the rows in
+	// Each vertex only writes its own row, so both passes split up by vertex without any locking
+	int count = vertices_.size();
+	graph.offsets.assign(count + 1, 0);
+	graph.neighbours.clear();
+	graph.lengths.clear();
+
+	std::unique_ptr<TaskPool> tasks;
+	if (threads > 1)
+	{
+		tasks.reset(new TaskPool(threads));
+	}
+
+	RunChunks(tasks.get(), count, [this, &graph](int begin, int end)
+	{
+		for (int v = begin; v < end; v++)
+		{
+			Edge* first = vertices_[v]->edge();
+			int degree = 0;
+			if (first != nullptr)
+			{
+				Edge* e = first;
+				do
+				{
+					degree++;
+					e = e->Onext();
+				} while (e != first);
+			}
+			graph.offsets[v + 1] = degree;
+		}
+	});
+
+	for (int v = 0; v < count; v++)
+	{
+		graph.offsets[v + 1] += graph.offsets[v];
+	}
+
+	graph.neighbours.resize(graph.offsets[count]);
+	if (lengths)
+	{
+		graph.lengths.resize(graph.offsets[count]);
+	}
+
+	// Onext turns counterclockwise around the origin, so the rows come out in counterclockwise order for free
+	RunChunks(tasks.get(), count, [this, &graph, lengths](int begin, int end)
+	{
+		for (int v = begin; v < end; v++)
+		{
+			Edge* first = vertices_[v]->edge();
+			if (first == nullptr)
+			{
+				continue;
+			}
+
+			int slot = graph.offsets[v];
+			Edge* e = first;
+			do
+			{
+				graph.neighbours[slot] = e->destination()->id();
+				if (lengths)
+				{
+					graph.lengths[slot] = std::sqrt(DistanceSquared(e->origin(), e->destination()));
+				}
+				slot++;
+				e = e->Onext();
+			} while (e != first);
+		}
+	});
+}
+
+//	--------------------------------------------------------
+//	Incremental updates
+//	--------------------------------------------------------
+
+// True if the face on e's left is a real triangle rather than the outside of the hull
+bool Delaunay::IsTriangle(Edge* e)
+{
+	return e->Lnext()->Lnext()->Lnext() == e && CCW(e->origin(), e->destination(), e->Lnext()->destination());
+}
+
+// Visibility walk: keep stepping across whichever side of the current triangle has p strictly on the far side
+// On a Delaunay triangulation this can't go round in circles, whatever order the sides get tried in
+Location Delaunay::Walk(Vert* p, Edge*& e)
+{
+	if (!IsTriangle(e))
+	{
+		e = e->Sym();
+	}
+
+	while (true)
+	{
+		// We just came across e, so p can't be right of it; try the other two sides first
+		Edge* sides[3] = { e->Lnext(), e->Lprev(), e };
+		bool crossed = false;
+
+		for (int k = 0; k < 3 && !crossed; k++)
+		{
+			if (RightOf(sides[k], p))
+			{
+				if (!IsTriangle(sides[k]->Sym()))
+				{
+					e = sides[k];
+					return LOCATED_OUTSIDE;
+				}
+				e = sides[k]->Sym();
+				crossed = true;
+			}
+		}
+
+		if (crossed)
+		{
+			continue;
+		}
+
+		// Nothing left to cross, so p is in the closed triangle; sort out whether it's on a corner or a side
+		for (int k = 0; k < 3; k++)
+		{
+			if (p->x() == sides[k]->origin()->x() && p->y() == sides[k]->origin()->y())
+			{
+				e = sides[k];
+				return LOCATED_VERTEX;
+			}
+		}
+		for (int k = 0; k < 3; k++)
+		{
+			if (!LeftOf(sides[k], p))
+			{
+				e = sides[k];
+				return LOCATED_EDGE;
+			}
+		}
+		return LOCATED_FACE;
+	}
+}
+
+// Turns e into the other diagonal of the quadrilateral formed by its two triangles; see Guibas and Stolfi
+// The QuadEdge stays where it is, so nothing gets reallocated
+void Delaunay::Swap(Edge* e)
+{
+	// Same as in Kill, the endpoints can't keep pointing at an edge that's about to leave them
+	Vert* org = e->origin();
+	Vert* dest = e->destination();
+	if (org->edge() == e)
+	{
+		org->AddEdge(e->Onext());
+	}
+	if (dest->edge() == e->Sym())
+	{
+		dest->AddEdge(e->Sym()->Onext());
+	}
+
+	Edge* a = e->Oprev();
+	Edge* b = e->Sym()->Oprev();
+
+	Splice(e, a);
+	Splice(e->Sym(), b);
+	Splice(e, a->Lnext());
+	Splice(e->Sym(), b->Lnext());
+
+	e->setOrigin(a->destination());
+	e->setDestination(b->destination());
+}
+
+// v is strictly inside the triangle left of e; fan it out to the corners
+void Delaunay::InsertInFace(Vert* v, Edge* e)
+{
+	// Straight out of Guibas and Stolfi
+	Edge* base = Edge::Make(edges_);
+	base->setOrigin(e->origin());
+	base->setDestination(v);
+	Splice(base, e);
+
+	Edge* start = base;
+	do
+	{
+		base = Connect(e, base->Sym(), edges_);
+		e = base->Oprev();
+	} while (e->Lnext() != start);
+}
+
+// v is strictly inside e, which has a triangle on its left and maybe one on its right
+void Delaunay::InsertOnEdge(Vert* v, Edge* e)
+{
+	// Remember where e sat around both ends and which sides had triangles, then replace it with two halves through v
+	// (Connecting to b_prev puts the far end back on e's destination, so only the origin needs keeping)
+	Vert* a = e->origin();
+	Edge* a_prev = e->Oprev();
+	Edge* b_prev = e->Sym()->Oprev();
+	bool right_triangle = IsTriangle(e->Sym());
+
+	Kill(e);
+
+	Edge* first = Edge::Make(edges_);
+	first->setOrigin(a);
+	first->setDestination(v);
+	Splice(first, a_prev);
+
+	Edge* second = Connect(first, b_prev, edges_);
+
+	// Then split whichever faces are now quadrilaterals by connecting v to the far corner
+	Connect(second->Lnext(), second, edges_);
+	if (right_triangle)
+	{
+		Connect(first->Sym()->Lnext(), first->Sym(), edges_);
+	}
+}
+
+// v is strictly right of e, a hull edge with the inside on its left; hook v up to every hull edge that can see it
+void Delaunay::InsertOutside(Vert* v, Edge* e)
+{
+	// The first triangle, on the far side of e
+	Edge* hull = e->Sym();
+	Edge* base = Edge::Make(edges_);
+	base->setOrigin(hull->origin());
+	base->setDestination(v);
+	Splice(base, hull);
+	Edge* left_edge = Connect(hull, base->Sym(), edges_)->Sym();
+	Edge* right_edge = base;
+
+	// Then walk along the outside of the hull both ways, adding a triangle for every edge v is strictly beyond
+	// (Going round the outside, "beyond" is on the left)
+	while (LeftOf(left_edge->Lnext(), v))
+	{
+		left_edge = Connect(left_edge->Lnext(), left_edge, edges_)->Sym();
+	}
+	while (LeftOf(right_edge->Lprev(), v))
+	{
+		right_edge = Connect(right_edge, right_edge->Lprev(), edges_)->Sym();
+	}
+}
+
+// Lawson's flips: every triangle that v just became part of gets its far side checked, and flipped if the triangle beyond is in conflict
+// Each flip hands v two more far sides to check
+void Delaunay::RestoreDelaunay(Vert* v)
+{
+	EdgeList stack;
+	Edge* start = v->edge();
+	Edge* s = start;
+	do
+	{
+		if (IsTriangle(s))
+		{
+			stack.push_back(s->Lnext());
+		}
+		s = s->Onext();
+	} while (s != start);
+
+	while (!stack.empty())
+	{
+		Edge* e = stack.back();
+		stack.pop_back();
+
+		// Something might already have flipped it out from under v, and hull edges have nothing beyond them
+		if (e->Lnext()->destination() != v || !IsTriangle(e) || !IsTriangle(e->Sym()))
+		{
+			continue;
+		}
+
+		Vert* far = e->Sym()->Lnext()->destination();
+		if (InCircle(e->origin(), e->destination(), v, far))
+		{
+			Swap(e);
+			stack.push_back(e->Lprev());
+			stack.push_back(e->Sym()->Lnext());
+		}
+	}
+}
+
+// Starts over from the vertex list, which needs to be sorted again first
+// Only used while there are too few points, or they're too close to collinear, for there to be a triangle to walk from
+void Delaunay::Rebuild()
+{
+	std::vector<int> order(vertices_.size());
+	for (int i = 0; i < order.size(); i++)
+	{
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [this](int a, int b)
+	{
+		Vert* p = vertices_[a];
+		Vert* q = vertices_[b];
+		return (p->x() < q->x()) || (p->x() == q->x() && p->y() < q->y());
+	});
+
+	PointsList sorted;
+	std::vector<int> sources;
+	for (int i = 0; i < order.size(); i++)
+	{
+		sorted.push_back(vertices_[order[i]]);
+		sorted.back()->setId(i);
+		sorted.back()->AddEdge(nullptr);
+		sources.push_back(sources_[order[i]]);
+	}
+	vertices_.swap(sorted);
+	sources_.swap(sources);
+
+	edges_.Clear();
+	hint_ = nullptr;
+	locator_.Clear();
+	GetTriangulation();
+
+	if (voronoi_live_)
+	{
+		GetVoronoi();
+	}
+}
+
+void Delaunay::UpdateDual(Edge* edge)
+{
+	// Same answer as GetVoronoi, one edge at a time
+	QuadEdge* raw = (QuadEdge*)(edge - (edge->index()));
+	Edge* e = raw->edges;
+
+	ReleaseDual(e[1].origin());
+	ReleaseDual(e[3].origin());
+
+	if (!CCW(e[0].origin(), e[0].destination(), e[0].Onext()->destination())
+		|| !CCW(e[0].origin(), e[0].Oprev()->destination(), e[0].destination()))
+	{
+		e[1].clearOrigin();
+		e[3].clearOrigin();
+		return;
+	}
+
+	// Each dual gets a circumcenter of its own here, rather than one shared across the triangle, so Kill can hand them back one quad at a time
+	double x, y;
+	Vert* a = e[0].origin();
+	Vert* b = e[0].destination();
+	Vert* c = e[0].Onext()->destination();
+	Circumcenter(a->x(), a->y(), b->x(), b->y(), c->x(), c->y(), x, y);
+	e[3].setOrigin(dual_pool_.Make(CoordFromDouble(x), CoordFromDouble(y)));
+
+	c = e[0].Oprev()->destination();
+	Circumcenter(a->x(), a->y(), c->x(), c->y(), b->x(), b->y(), x, y);
+	e[1].setOrigin(dual_pool_.Make(CoordFromDouble(x), CoordFromDouble(y)));
+}
+
+void Delaunay::UpdateDualsAround(Vert* v)
+{
+	// Every triangle that changed has v as a corner, so its sides are either spokes out of v or the edges across from it
+	Edge* start = v->edge();
+	Edge* s = start;
+	do
+	{
+		UpdateDual(s);
+		UpdateDual(s->Lnext());
+		s = s->Onext();
+	} while (s != start);
+}
+
+void Delaunay::ReleaseDual(Vert* dual)
+{
+	// Anything that isn't in voronoi_verts_ came out of the pool
+	if (dual != nullptr && (std::less<Vert*>()(dual, voronoi_verts_.data())
+		|| !std::less<Vert*>()(dual, voronoi_verts_.data() + voronoi_verts_.size())))
+	{
+		dual_pool_.Release(dual);
+	}
+}
+
+Vert* Delaunay::Insert(Coord x, Coord y)
+{
+	if (!std::isfinite(x) || !std::isfinite(y))
+	{
+		return nullptr;
+	}
+
+	// Until there's a triangle to walk from, just add the point and start over; that only lasts while everything's collinear
+	if (vertices_.size() < 3 || edges_.quads.size() < vertices_.size())
+	{
+		for (auto i = vertices_.begin(); i != vertices_.end(); i++)
+		{
+			if ((*i)->x() == x && (*i)->y() == y)
+			{
+				return *i;
+			}
+		}
+
+		Vert* v = vert_pool_.Make(x, y);
+		vertices_.push_back(v);
+		sources_.push_back(-1);
+		Rebuild();
+		return v;
+	}
+
+	// Find where it lands
+	Vert probe(x, y);
+	Edge* e = StartEdge(&probe);
+	Location where = Walk(&probe, e);
+
+	if (where == LOCATED_VERTEX)
+	{
+		hint_ = e;
+		return e->origin();
+	}
+
+	Vert* v = vert_pool_.Make(x, y);
+	v->setId(vertices_.size());
+	vertices_.push_back(v);
+	sources_.push_back(-1);
+
+	// Hook it into the mesh, then flip until it's Delaunay again
+	if (where == LOCATED_FACE)
+	{
+		InsertInFace(v, e);
+	}
+	else if (where == LOCATED_EDGE)
+	{
+		InsertOnEdge(v, e);
+	}
+	else
+	{
+		InsertOutside(v, e);
+	}
+
+	RestoreDelaunay(v);
+
+	if (voronoi_live_)
+	{
+		UpdateDualsAround(v);
+	}
+
+	locator_.Update(x, y, v->id());
+	hint_ = v->edge();
+	return v;
+}
+
+// Closes up the hole left by v's spokes, given the edges around it in order with the hole on their left; v is still where it was
+// A closed boundary goes all the way round and ends up as one last triangle; an open one (from a hull vertex) stops once it's convex
+//
+// Two steps. First clip ears to get any triangulation at all, taking an ear only if it's convex and v stays on the hole's side of
+// the new diagonal: the hole is star-shaped round v, so such an ear can't have another corner inside it, and what's left stays
+// star-shaped. Ears whose circle misses the next corner on either side go first, which is usually right. The scan steps back one
+// corner after every clip, like Graham's, and each test looks at no more than five corners, so it's a linear number of constant-time
+// tests unless a whole lap goes by with no locally empty ear, which costs another lap.
+// Then Lawson-flip the new diagonals until they're all locally Delaunay, which makes the whole thing Delaunay. The old sides
+// never flip, since the triangles beyond them were Delaunay without v. On anything but contrived input the ears leave few flips to do
+void Delaunay::FillHole(Vert* v, EdgeList& boundary, bool closed, EdgeList& made)
+{
+	// The boundary as a ring (or, open, a chain) of positions, so clipping is O(1)
+	int m = boundary.size();
+	std::vector<int> next(m);
+	std::vector<int> prev(m);
+	for (int i = 0; i < m; i++)
+	{
+		next[i] = (i + 1 < m) ? i + 1 : (closed ? 0 : -1);
+		prev[i] = (i > 0) ? i - 1 : (closed ? m - 1 : -1);
+	}
+
+	// The ear at i is the corner between boundary[i] and the side after it
+	// picky says whether it also has to be locally empty; misses counts tests since the last clip, and a whole lap of them changes the rules
+	int left = m;
+	int i = 0;
+	int misses = 0;
+	bool picky = true;
+	while ((closed ? left > 3 : left > 1))
+	{
+		if (misses > left)
+		{
+			// Nothing locally empty in a whole lap, so take any valid ear; if there's none of those either, an open chain is convex and done
+			if (!picky)
+			{
+				break;
+			}
+			picky = false;
+			misses = 0;
+		}
+
+		if (next[i] < 0)
+		{
+			// The end of an open chain has no corner after it; go round again from the start
+			while (prev[i] >= 0)
+			{
+				i = prev[i];
+			}
+			misses++;
+			continue;
+		}
+
+		Edge* a = boundary[i];
+		Edge* b = boundary[next[i]];
+		Vert* p = a->origin();
+		Vert* q = a->destination();
+		Vert* r = b->destination();
+
+		bool ear = CCW(p, q, r) && !CCW(r, p, v);
+		if (ear && picky)
+		{
+			if (prev[i] >= 0 && boundary[prev[i]]->origin() != r)
+			{
+				ear = !InCircle(p, q, r, boundary[prev[i]]->origin());
+			}
+			if (ear && next[next[i]] >= 0 && boundary[next[next[i]]]->destination() != p)
+			{
+				ear = !InCircle(p, q, r, boundary[next[next[i]]]->destination());
+			}
+		}
+
+		if (!ear)
+		{
+			i = (next[i] >= 0) ? next[i] : i;
+			misses++;
+			continue;
+		}
+
+		// Cut it off; the new edge takes the place of the two it spans
+		Edge* diagonal = Connect(b, a, edges_);
+		made.push_back(diagonal);
+		boundary[i] = diagonal->Sym();
+		int gone = next[i];
+		next[i] = next[gone];
+		if (next[i] >= 0)
+		{
+			prev[next[i]] = i;
+		}
+		left--;
+		misses = 0;
+		picky = true;
+
+		// The corner before this one just changed, so it's the one to look at next
+		i = (prev[i] >= 0) ? prev[i] : i;
+	}
+
+	// Every edge Legalize flips stays in made, so the caller's list of what changed is still right afterwards
+	EdgeList suspects = made;
+	EdgeList flipped;
+	Legalize(suspects, flipped);
+}
+
+// Takes v out of the vertex list and gives it back to the pool; the last vertex moves into its slot
+void Delaunay::DropVertex(Vert* v)
+{
+	int id = v->id();
+	vertices_[id] = vertices_.back();
+	vertices_[id]->setId(id);
+	sources_[id] = sources_.back();
+	vertices_.pop_back();
+	sources_.pop_back();
+	vert_pool_.Release(v);
+}
+
+// Cuts v out of the mesh and fills in the hole it leaves, without giving the Vert back; see Remove
+// links are the sides of the hole and made the new diagonals, which between them bound every triangle that changed
+void Delaunay::CutOut(Vert* v, EdgeList& links, EdgeList& made)
+{
+	// Go round v; on the hull, start just after the gap so the boundary comes out as one unbroken chain
+	Edge* start = v->edge();
+	Edge* s = start;
+	do
+	{
+		if (!IsTriangle(s))
+		{
+			start = s->Onext();
+			break;
+		}
+		s = s->Onext();
+	} while (s != start);
+	bool closed = (s == start && IsTriangle(s));
+
+	// The far side of each triangle around v becomes the boundary of the hole
+	EdgeList spokes;
+	EdgeList boundary;
+	s = start;
+	do
+	{
+		spokes.push_back(s);
+		if (IsTriangle(s))
+		{
+			boundary.push_back(s->Lnext());
+		}
+		s = s->Onext();
+	} while (s != start);
+
+	for (auto i = spokes.begin(); i != spokes.end(); i++)
+	{
+		Kill(*i);
+	}
+
+	// Killed quads go back on the free list, so the new edges reuse them
+	links = boundary;
+	FillHole(v, boundary, closed, made);
+	hint_ = made.empty() ? boundary[0] : made.back();
+}
+
+bool Delaunay::Remove(Vert* v)
+{
+	if (v == nullptr || v->id() < 0 || v->id() >= vertices_.size() || vertices_[v->id()] != v)
+	{
+		return false;
+	}
+
+	// Same as Insert: with no triangle to work from, start over
+	if (vertices_.size() <= 3 || edges_.quads.size() < vertices_.size())
+	{
+		DropVertex(v);
+		Rebuild();
+		return true;
+	}
+
+	EdgeList links;
+	EdgeList made;
+	CutOut(v, links, made);
+	DropVertex(v);
+
+	// The new triangles are all bounded by the old far sides and the new diagonals, so those are the only duals that change
+	if (voronoi_live_)
+	{
+		for (auto i = links.begin(); i != links.end(); i++)
+		{
+			UpdateDual(*i);
+		}
+		for (auto i = made.begin(); i != made.end(); i++)
+		{
+			UpdateDual(*i);
+		}
+	}
+
+	return true;
+}
+
+// The spoke out of v with the outside of the hull on its left, or nullptr if v is inside
+Edge* Delaunay::OutsideSpoke(Vert* v)
+{
+	Edge* start = v->edge();
+	Edge* s = start;
+	do
+	{
+		if (!IsTriangle(s))
+		{
+			return s;
+		}
+		s = s->Onext();
+	} while (s != start);
+
+	return nullptr;
+}
+
+// True if the triangles around v are all the right way round and go round it exactly once, or on the hull, less than once
+// gap is the spoke with the outside on its left, or nullptr if v is inside
+// All positive triangles isn't enough by itself: after a big enough jump they can wrap round v twice
+bool Delaunay::StarValid(Vert* v, Edge* gap)
+{
+	// Count the wedges the first spoke's direction falls in, past their start and up to and including their end
+	// Going round once, that's just the last wedge (which ends on it); on the hull, where the last wedge stops short, it's none
+	Edge* first = (gap != nullptr) ? gap->Onext() : v->edge();
+	Vert* u = first->destination();
+	int wraps = 0;
+
+	for (Edge* s = first; s != gap; )
+	{
+		Vert* a = s->destination();
+		Vert* b = s->Onext()->destination();
+		if (!CCW(v, a, b))
+		{
+			return false;
+		}
+		if (CCW(v, a, u) && !CCW(v, b, u))
+		{
+			wraps++;
+		}
+
+		s = s->Onext();
+		if (s == first)
+		{
+			break;
+		}
+	}
+
+	return wraps == ((gap == nullptr) ? 1 : 0);
+}
+
+// Nothing turned inside out, but a hull vertex that moved inwards leaves a dent, and the hull has to be convex
+// Fill each one with a triangle across it, outside; that can dent the neighbours in turn, so they get checked too
+// Returns false if a new triangle overlaps the neighbours' (only a big jump does that), in which case the caller has to Kill what's in made
+bool Delaunay::FillDents(PointsList& hull, EdgeList& made)
+{
+	while (!hull.empty())
+	{
+		Vert* w = hull.back();
+		hull.pop_back();
+
+		// The outside wedge runs from gap round to first; if it's less than half a turn, w is a dent
+		Edge* gap = OutsideSpoke(w);
+		if (gap == nullptr || !CCW(w, gap->destination(), gap->Onext()->destination()))
+		{
+			continue;
+		}
+
+		// gap, the new edge and first (backwards) go round the new triangle, and w ends up inside
+		Edge* first = gap->Onext();
+		Edge* across = Connect(gap, first->Sym(), edges_);
+		made.push_back(across);
+
+		Vert* a = across->origin();
+		Vert* b = across->destination();
+		if (!StarValid(a, OutsideSpoke(a)) || !StarValid(b, OutsideSpoke(b)))
+		{
+			return false;
+		}
+		hull.push_back(a);
+		hull.push_back(b);
+	}
+
+	return true;
+}
+
+// Lawson's flips over any set of suspect edges: flip each one whose far corner is in the circle, then suspect the four around it
+// On a valid triangulation this always finishes, since every flip lowers the lifted surface
+void Delaunay::Legalize(EdgeList& suspects, EdgeList& flipped)
+{
+	while (!suspects.empty())
+	{
+		Edge* e = suspects.back();
+		suspects.pop_back();
+
+		if (!IsTriangle(e) || !IsTriangle(e->Sym()))
+		{
+			continue;
+		}
+
+		Vert* far = e->Sym()->Lnext()->destination();
+		if (InCircle(e->origin(), e->destination(), e->Lnext()->destination(), far))
+		{
+			Swap(e);
+			flipped.push_back(e);
+			suspects.push_back(e->Lnext());
+			suspects.push_back(e->Lprev());
+			suspects.push_back(e->Sym()->Lnext());
+			suspects.push_back(e->Sym()->Lprev());
+		}
+	}
+}
+
+// The cheap way to move v: put it at (x, y) and, as long as its triangles and its neighbours' still go round once, fix things up with flips
+// Returns false, with v and the mesh as they were, if some triangle would turn inside out
+bool Delaunay::ShiftVertex(Vert* v, Coord x, Coord y)
+{
+	// v and its neighbours are the only vertices whose triangles change
+	// Which of their spokes faces the outside has to be worked out now, while the positions still agree with the mesh
+	PointsList affected(1, v);
+	Edge* start = v->edge();
+	Edge* s = start;
+	do
+	{
+		affected.push_back(s->destination());
+		s = s->Onext();
+	} while (s != start);
+
+	EdgeList gaps;
+	for (auto i = affected.begin(); i != affected.end(); i++)
+	{
+		gaps.push_back(OutsideSpoke(*i));
+	}
+
+	Coord old_x = v->x();
+	Coord old_y = v->y();
+	v->setPosition(x, y);
+
+	// Landing on another vertex would need a flat or flipped triangle between them somewhere, so that gets caught here too
+	bool valid = true;
+	PointsList hull;
+	for (int i = 0; i < affected.size() && valid; i++)
+	{
+		valid = StarValid(affected[i], gaps[i]);
+		if (gaps[i] != nullptr)
+		{
+			hull.push_back(affected[i]);
+		}
+	}
+
+	EdgeList made;
+	if (valid)
+	{
+		valid = FillDents(hull, made);
+	}
+
+	if (!valid)
+	{
+		// Connect and Kill undo each other, so taking the fills back out newest first leaves the old mesh
+		for (auto i = made.rbegin(); i != made.rend(); i++)
+		{
+			Kill(*i);
+		}
+		v->setPosition(old_x, old_y);
+		return false;
+	}
+
+	// Only edges touching v's triangles can have gone bad: its spokes and the sides across from it, plus anything filled in
+	EdgeList suspects;
+	EdgeList flipped;
+	s = start = v->edge();
+	do
+	{
+		suspects.push_back(s);
+		if (IsTriangle(s))
+		{
+			suspects.push_back(s->Lnext());
+		}
+		s = s->Onext();
+	} while (s != start);
+	for (auto i = made.begin(); i != made.end(); i++)
+	{
+		suspects.push_back(*i);
+		suspects.push_back((*i)->Lnext());
+		suspects.push_back((*i)->Lprev());
+	}
+	Legalize(suspects, flipped);
+
+	// Every triangle with v as a corner has a new circumcenter, and so do both sides of every flip and fill
+	if (voronoi_live_)
+	{
+		UpdateDualsAround(v);
+		flipped.insert(flipped.end(), made.begin(), made.end());
+		for (auto i = flipped.begin(); i != flipped.end(); i++)
+		{
+			Edge* e = *i;
+			Edge* around[5] = { e, e->Lnext(), e->Lprev(), e->Sym()->Lnext(), e->Sym()->Lprev() };
+			for (int k = 0; k < 5; k++)
+			{
+				UpdateDual(around[k]);
+			}
+		}
+	}
+
+	hint_ = v->edge();
+	return true;
+}
+
+// The expensive way: cut v out, then insert it again at (x, y) like a new point, keeping the same Vert and id
+// If somebody else is already at (x, y), v goes back where it was instead
+// Returns false if cutting v out left nothing but a line, in which case everything gets rebuilt (and renumbered) with v at (x, y)
+bool Delaunay::Relocate(Vert* v, Coord x, Coord y)
+{
+	Coord old_x = v->x();
+	Coord old_y = v->y();
+
+	EdgeList links;
+	EdgeList made;
+	CutOut(v, links, made);
+
+	// Every triangle that's left is next to one that v was part of, so if none of those have a triangle beyond them, nothing does
+	bool triangles = !made.empty();
+	for (auto i = links.begin(); i != links.end() && !triangles; i++)
+	{
+		triangles = IsTriangle(*i) || IsTriangle((*i)->Sym());
+	}
+
+	if (!triangles)
+	{
+		v->setPosition(x, y);
+		std::vector<Coord> old = { old_x, old_y };
+		SeparateMoved(PointsList(1, v), old);
+		Rebuild();
+		return false;
+	}
+
+	if (voronoi_live_)
+	{
+		for (auto i = links.begin(); i != links.end(); i++)
+		{
+			UpdateDual(*i);
+		}
+		for (auto i = made.begin(); i != made.end(); i++)
+		{
+			UpdateDual(*i);
+		}
+	}
+
+	Vert probe(x, y);
+	Edge* e = StartEdge(&probe);
+	Location where = Walk(&probe, e);
+	if (where == LOCATED_VERTEX)
+	{
+		// Where v just was can't be taken, since all the positions were distinct to begin with
+		probe = Vert(old_x, old_y);
+		e = StartEdge(&probe);
+		where = Walk(&probe, e);
+	}
+	else
+	{
+		v->setPosition(x, y);
+	}
+
+	if (where == LOCATED_FACE)
+	{
+		InsertInFace(v, e);
+	}
+	else if (where == LOCATED_EDGE)
+	{
+		InsertOnEdge(v, e);
+	}
+	else
+	{
+		InsertOutside(v, e);
+	}
+
+	RestoreDelaunay(v);
+
+	if (voronoi_live_)
+	{
+		UpdateDualsAround(v);
+	}
+
+	hint_ = v->edge();
+	return true;
+}
+
+// Before starting over, make sure no two vertices ended up in the same spot: the later of a pair goes back where it was
+// Putting one back can land it on somebody else's new spot, so go round again until nothing's shared; the old spots were all distinct, so this stops
+void Delaunay::SeparateMoved(const PointsList& moved, const std::vector<Coord>& old)
+{
+	std::unordered_map<Vert*, int> which;
+	for (int i = 0; i < moved.size(); i++)
+	{
+		which[moved[i]] = i;
+	}
+
+	bool reverted = true;
+	while (reverted)
+	{
+		reverted = false;
+
+		PointsList sorted = vertices_;
+		std::sort(sorted.begin(), sorted.end(), [](Vert* p, Vert* q)
+		{
+			return (p->x() < q->x()) || (p->x() == q->x() && p->y() < q->y());
+		});
+
+		for (int i = 1; i < sorted.size(); i++)
+		{
+			if (sorted[i]->x() != sorted[i - 1]->x() || sorted[i]->y() != sorted[i - 1]->y())
+			{
+				continue;
+			}
+
+			// One of the pair has to have moved, and not been put back yet
+			for (int k = 0; k < 2; k++)
+			{
+				auto found = which.find(sorted[i - k]);
+				if (found != which.end())
+				{
+					int m = found->second;
+					sorted[i - k]->setPosition(old[2 * m], old[2 * m + 1]);
+					which.erase(found);
+					reverted = true;
+					break;
+				}
+			}
+		}
+	}
+}
+
+bool Delaunay::Move(const PointsList& verts, const Coord* xy)
+{
+	// Weed out anything that isn't ours or isn't going anywhere we can represent
+	PointsList moved;
+	std::vector<Coord> targets;
+	for (int i = 0; i < verts.size(); i++)
+	{
+		Vert* v = verts[i];
+		if (v != nullptr && v->id() >= 0 && v->id() < vertices_.size() && vertices_[v->id()] == v
+			&& std::isfinite(xy[2 * i]) && std::isfinite(xy[2 * i + 1]))
+		{
+			moved.push_back(v);
+			targets.push_back(xy[2 * i]);
+			targets.push_back(xy[2 * i + 1]);
+		}
+	}
+
+	// One at a time, so the mesh is Delaunay again before each one and the walks in Relocate can trust it
+	// A small step usually only needs flips; a step that turns a triangle inside out gets v cut out and put back in instead
+	int done = 0;
+	bool meshed = vertices_.size() >= 3 && edges_.quads.size() >= vertices_.size();
+	for (; meshed && done < moved.size(); done++)
+	{
+		Vert* v = moved[done];
+		if (!ShiftVertex(v, targets[2 * done], targets[2 * done + 1]) && !Relocate(v, targets[2 * done], targets[2 * done + 1]))
+		{
+			meshed = false;
+		}
+	}
+
+	if (done == moved.size() && meshed)
+	{
+		return true;
+	}
+
+	// With no triangle to work from there's nothing to repair, so whoever's left moves and everything starts over, like Insert does
+	PointsList rest(moved.begin() + done, moved.end());
+	std::vector<Coord> old;
+	for (int i = done; i < moved.size(); i++)
+	{
+		old.push_back(moved[i]->x());
+		old.push_back(moved[i]->y());
+		moved[i]->setPosition(targets[2 * i], targets[2 * i + 1]);
+	}
+	SeparateMoved(rest, old);
+	Rebuild();
+	return false;
+}
+
+//	--------------------------------------------------------
+//	Point location
+//	--------------------------------------------------------
+
+Edge* Delaunay::StartEdge(Vert* p)
+{
+	// Whichever of the last walk's end and the grid's pick is closer to p
+	if (locator_.Stale(vertices_.size()))
+	{
+		locator_.Build(vertices_);
+	}
+
+	Vert* best = (hint_ != nullptr) ? hint_->origin() : nullptr;
+	int seed = locator_.Seed(p->x(), p->y());
+	if (seed >= 0 && seed < vertices_.size() && vertices_[seed]->edge() != nullptr)
+	{
+		Vert* candidate = vertices_[seed];
+		if (best == nullptr || DistanceSquared(candidate, p) < DistanceSquared(best, p))
+		{
+			best = candidate;
+		}
+	}
+
+	return (best != nullptr) ? best->edge() : edges_.quads[0]->edges;
+}
+
+Edge* Delaunay::Locate(Coord x, Coord y, Location& where)
+{
+	if (!std::isfinite(x) || !std::isfinite(y) || vertices_.size() < 3 || edges_.quads.size() < vertices_.size())
+	{
+		return nullptr;
+	}
+
+	Vert probe(x, y);
+	Edge* e = StartEdge(&probe);
+	where = Walk(&probe, e);
+	hint_ = e;
+	return e;
+}
+
+Vert* Delaunay::Nearest(Coord x, Coord y)
+{
+	if (!std::isfinite(x) || !std::isfinite(y) || vertices_.empty())
+	{
+		return nullptr;
+	}
+
+	Vert probe(x, y);
+	Vert* v = nullptr;
+
+	if (edges_.quads.empty())
+	{
+		// Nothing to walk along, so check them all
+		v = vertices_[0];
+		for (auto i = vertices_.begin(); i != vertices_.end(); i++)
+		{
+			if (DistanceSquared(*i, &probe) < DistanceSquared(v, &probe))
+			{
+				v = *i;
+			}
+		}
+		return v;
+	}
+
+	// Greedy walk: if v isn't the closest site, the line from v to the probe leaves v's Voronoi cell into a neighbour's,
+	// and that neighbour is closer, so stepping to any closer neighbour can't get stuck short of the answer
+	v = StartEdge(&probe)->origin();
+	double best = DistanceSquared(v, &probe);
+	bool moved = true;
+	while (moved)
+	{
+		moved = false;
+		Edge* start = v->edge();
+		Edge* e = start;
+		do
+		{
+			double d = DistanceSquared(e->destination(), &probe);
+			if (d < best)
+			{
+				best = d;
+				v = e->destination();
+				moved = true;
+				break;
+			}
+			e = e->Onext();
+		} while (e != start);
+	}
+
+	hint_ = v->edge();
+	return v;
+}
+
+void Delaunay::Locate(const Coord* xy, int count, EdgeList& edges, std::vector<Location>& where)
+{
+	edges.resize(count);
+	where.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		Location here = LOCATED_OUTSIDE;
+		edges[i] = Locate(xy[2 * i], xy[2 * i + 1], here);
+		where[i] = here;
+	}
+}
+
+void Delaunay::Nearest(const Coord* xy, int count, PointsList& verts)
+{
+	verts.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		verts[i] = Nearest(xy[2 * i], xy[2 * i + 1]);
+	}
+}
+
+//	--------------------------------------------------------
+//	Rasterizing
+//	--------------------------------------------------------
+
+// Every triangle once, by the side that owns it, and its three corners counterclockwise from there
+// The corners get looked at over and over while filing and scanning, so it's worth not going round the edges for them each time
+// Same count-then-fill split as GetTriangles when there are threads
+void Delaunay::CollectFaces(EdgeList& faces, PointsList& corners, TaskPool* tasks)
+{
+	int count = edges_.quads.size();
+	faces.clear();
+	corners.clear();
+
+	if (tasks == nullptr)
+	{
+		faces.reserve(2 * vertices_.size());
+		corners.reserve(6 * vertices_.size());
+		for (int i = 0; i < count; i++)
+		{
+			Edge* e = edges_.quads[i]->edges;
+			for (int side = 0; side < 2; side++)
+			{
+				Edge* s = &e[2 * side];
+				if (OwnsFace(s))
+				{
+					faces.push_back(s);
+					corners.push_back(s->origin());
+					corners.push_back(s->destination());
+					corners.push_back(s->Lnext()->destination());
+				}
+			}
+		}
+		return;
+	}
+
+	FaceTable table;
+	table.owned.resize(count);
+	table.first_face.assign(count + 1, 0);
+	RunChunks(tasks, count, [this, &table](int begin, int end) { CountFaces(begin, end, table); });
+
+	for (int i = 0; i < count; i++)
+	{
+		table.first_face[i + 1] += table.first_face[i];
+	}
+
+	faces.resize(table.first_face[count]);
+	corners.resize(3 * faces.size());
+	RunChunks(tasks, count, [this, &table, &faces, &corners](int begin, int end)
+	{
+		int k = table.first_face[begin];
+		for (int i = begin; i < end; i++)
+		{
+			Edge* e = edges_.quads[i]->edges;
+			for (int side = 0; side < 2; side++)
+			{
+				if (table.owned[i] & (1 << side))
+				{
+					Edge* s = &e[2 * side];
+					faces[k] = s;
+					corners[3 * k] = s->origin();
+					corners[3 * k + 1] = s->destination();
+					corners[3 * k + 2] = s->Lnext()->destination();
+					k++;
+				}
+			}
+		}
+	});
+}
+
+// The cells whose centres fall in the bounding box of a face's corners, clipped to the grid; false if there aren't any
+bool Delaunay::FaceCells(const RasterGrid& grid, Vert* const* corners, int& first_column, int& last_column, int& first_row, int& last_row)
+{
+	Vert* a = corners[0];
+	Vert* b = corners[1];
+	Vert* c = corners[2];
+
+	double low_x = std::min({ (double)a->x(), (double)b->x(), (double)c->x() });
+	double high_x = std::max({ (double)a->x(), (double)b->x(), (double)c->x() });
+	double low_y = std::min({ (double)a->y(), (double)b->y(), (double)c->y() });
+	double high_y = std::max({ (double)a->y(), (double)b->y(), (double)c->y() });
+
+	first_column = std::max(FirstCell(low_x, grid.x0, grid.cell_width), 0);
+	last_column = std::min(LastCell(high_x, grid.x0, grid.cell_width), grid.width - 1);
+	first_row = std::max(FirstCell(low_y, grid.y0, grid.cell_height), 0);
+	last_row = std::min(LastCell(high_y, grid.y0, grid.cell_height), grid.height - 1);
+
+	return first_column <= last_column && first_row <= last_row;
+}
+
+// Fill the cells of tile (tile_x, tile_y) that face covers
+void Delaunay::RasterFace(Edge* face, Vert* const* corners, const float* values, RasterGrid& grid, RasterMode mode, int tile_x, int tile_y, EdgeList& cavity, EdgeList& stack)
+{
+	double x[3], y[3], v[3];
+	for (int k = 0; k < 3; k++)
+	{
+		x[k] = corners[k]->x();
+		y[k] = corners[k]->y();
+		v[k] = values[corners[k]->id()];
+	}
+
+	int first_column, last_column, first_row, last_row;
+	FaceCells(grid, corners, first_column, last_column, first_row, last_row);
+	first_column = std::max(first_column, tile_x * RASTER_TILE);
+	last_column = std::min(last_column, tile_x * RASTER_TILE + RASTER_TILE - 1);
+	first_row = std::max(first_row, tile_y * RASTER_TILE);
+	last_row = std::min(last_row, tile_y * RASTER_TILE + RASTER_TILE - 1);
+
+	// The weights of corners 1 and 2 are linear in x, so along a row they just go up by a fixed step per cell
+	// The owner has its triangle on the left, so det is positive
+	double det = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+	double step_1 = grid.cell_width * (y[2] - y[0]) / det;
+	double step_2 = -grid.cell_width * (y[1] - y[0]) / det;
+
+	for (int j = first_row; j <= last_row; j++)
+	{
+		double row = grid.CellY(j);
+		double lo, hi;
+		if (!RowSpan(x, y, row, lo, hi))
+		{
+			continue;
+		}
+
+		int first = std::max(FirstCell(lo, grid.x0, grid.cell_width), first_column);
+		int last = std::min(LastCell(hi, grid.x0, grid.cell_width), last_column);
+		if (first > last)
+		{
+			continue;
+		}
+
+		double column = grid.CellX(first);
+		double weight_1 = ((column - x[0]) * (y[2] - y[0]) - (row - y[0]) * (x[2] - x[0])) / det;
+		double weight_2 = ((x[1] - x[0]) * (row - y[0]) - (y[1] - y[0]) * (column - x[0])) / det;
+
+		float* out = grid.values.data() + (size_t)j * grid.width;
+		for (int i = first; i <= last; i++)
+		{
+			double value = v[0] + weight_1 * (v[1] - v[0]) + weight_2 * (v[2] - v[0]);
+			if (mode == RASTER_NATURAL)
+			{
+				NaturalNeighbour(face, grid.CellX(i), row, values, cavity, stack, value);
+			}
+			out[i] = (float)value;
+
+			weight_1 += step_1;
+			weight_2 += step_2;
+		}
+	}
+}
+
+// The side that speaks for e's left face, so a triangle can be recognised whichever side it was reached from
+Edge* Delaunay::FaceKey(Edge* e)
+{
+	Edge* next = e->Lnext();
+	Edge* prev = next->Lnext();
+	Edge* key = std::less<Edge*>()(next, e) ? next : e;
+	return std::less<Edge*>()(prev, key) ? prev : key;
+}
+
+// Sibson's interpolant at p = (x, y), which lies in (or right on the edge of) face; value comes in holding the linear one and keeps it if the sum goes bad
+// Inserting p would destroy the triangles whose circumcircles it's in; p's new Voronoi cell is made of the bits it would steal from their corners' cells
+// There's no special case for the hull: strictly inside it p's new cell is bounded, so even when the cavity reaches a hull side the stolen bits
+// are the real ones, just bigger. Only the check at the end ever falls back to the linear value
+void Delaunay::NaturalNeighbour(Edge* face, double x, double y, const float* values, EdgeList& cavity, EdgeList& stack, double& value)
+{
+	// The triangles p would destroy are connected, and include the one it's in, so spread out from there
+	// There are only a handful, so a plain list is quicker to search than anything hashed
+	auto destroyed = [this, &cavity](Edge* e) { return std::find(cavity.begin(), cavity.end(), FaceKey(e)) != cavity.end(); };
+	cavity.clear();
+	stack.assign(1, face);
+	while (!stack.empty())
+	{
+		Edge* t = stack.back();
+		stack.pop_back();
+		if (destroyed(t))
+		{
+			continue;
+		}
+		cavity.push_back(FaceKey(t));
+
+		Edge* side = t;
+		for (int k = 0; k < 3; k++, side = side->Lnext())
+		{
+			Edge* across = side->Sym();
+			if (!IsTriangle(across))
+			{
+				continue;
+			}
+			Vert* a = across->origin();
+			Vert* b = across->destination();
+			Vert* c = across->Lnext()->destination();
+			if (InCircle2d(a->x(), a->y(), b->x(), b->y(), c->x(), c->y(), x, y) > 0)
+			{
+				stack.push_back(across);
+			}
+		}
+	}
+
+	// The cavity's rim runs counterclockwise along the sides with no cavity across them; every corner on it is one of p's natural neighbours
+	// What p steals from the corner b at the end of rim side a -> b is bounded by the circumcentres of p with the rim sides either side of b,
+	// and in between, the old Voronoi vertices of the cavity triangles round b. Only rim sides ever get near p, so those stay put unless p is on the hull
+	// Everything is relative to p, which keeps the numbers small
+	double total = 0;
+	double weighted = 0;
+	double low = std::numeric_limits<double>::infinity();
+	double high = -low;
+	for (auto t = cavity.begin(); t != cavity.end(); t++)
+	{
+		Edge* side = *t;
+		for (int k = 0; k < 3; k++, side = side->Lnext())
+		{
+			if (IsTriangle(side->Sym()) && destroyed(side->Sym()))
+			{
+				continue;
+			}
+
+			Vert* b = side->destination();
+			double start_x, start_y;
+			Circumcenter(x, y, side->origin()->x(), side->origin()->y(), b->x(), b->y(), start_x, start_y);
+			start_x -= x;
+			start_y -= y;
+
+			// Go clockwise round b from b -> a through the cavity, adding up the polygon's area as we go, until f is the next rim side
+			double last_x = start_x;
+			double last_y = start_y;
+			double area = 0;
+			Edge* f = side->Sym();
+			bool rim = false;
+			while (!rim)
+			{
+				f = f->Oprev();
+				rim = !IsTriangle(f->Oprev()) || !destroyed(f->Oprev());
+
+				double centre_x, centre_y;
+				Vert* c = f->Lnext()->destination();
+				Circumcenter(b->x(), b->y(), f->destination()->x(), f->destination()->y(), c->x(), c->y(), centre_x, centre_y);
+				centre_x -= x;
+				centre_y -= y;
+				area += last_x * centre_y - last_y * centre_x;
+				last_x = centre_x;
+				last_y = centre_y;
+			}
+
+			// Then out to p's circumcentre with the next rim side, b -> c, and back to the start
+			double end_x, end_y;
+			Circumcenter(x, y, b->x(), b->y(), f->destination()->x(), f->destination()->y(), end_x, end_y);
+			end_x -= x;
+			end_y -= y;
+			area += last_x * end_y - last_y * end_x;
+			area += end_x * start_y - end_y * start_x;
+
+			double sample = values[b->id()];
+			total += area;
+			weighted += area * sample;
+			low = std::min(low, sample);
+			high = std::max(high, sample);
+		}
+	}
+
+	// The weights are all positive, so the answer has to land between the neighbours' values; if it doesn't, or isn't finite, keep the linear one
+	// That happens right on a vertex or a hull side, where a rim circumcentre runs off to infinity, and very close to one, where rounding takes over
+	// The linear value is the limit there anyway. Anywhere else, near the hull or not, the Sibson value stands
+	double sibson = weighted / total;
+	if (std::isfinite(sibson) && sibson >= low && sibson <= high)
+	{
+		value = sibson;
+	}
+}
+
+void Delaunay::GetRaster(const float* values, RasterGrid& grid, RasterMode mode, int threads)
+{
+	int width = std::max(grid.width, 0);
+	int height = std::max(grid.height, 0);
+	grid.values.assign((size_t)width * height, grid.empty);
+
+	std::unique_ptr<TaskPool> tasks;
+	if (threads > 1)
+	{
+		tasks.reset(new TaskPool(threads));
+	}
+
+	EdgeList faces;
+	PointsList corners;
+	CollectFaces(faces, corners, tasks.get());
+
+	// File every face under each tile its cells could be in: count, sum the counts into offsets, then fill
+	// That's one quick pass over the faces; the rasterizing is where the time goes, and that splits up by tile
+	int across = (width + RASTER_TILE - 1) / RASTER_TILE;
+	int down = (height + RASTER_TILE - 1) / RASTER_TILE;
+	std::vector<int> first_filed(across * down + 1, 0);
+	std::vector<int> filed;
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int f = 0; f < faces.size(); f++)
+		{
+			int first_column, last_column, first_row, last_row;
+			if (!FaceCells(grid, &corners[3 * f], first_column, last_column, first_row, last_row))
+			{
+				continue;
+			}
+
+			for (int ty = first_row / RASTER_TILE; ty <= last_row / RASTER_TILE; ty++)
+			{
+				for (int tx = first_column / RASTER_TILE; tx <= last_column / RASTER_TILE; tx++)
+				{
+					if (pass == 0)
+					{
+						first_filed[ty * across + tx + 1]++;
+					}
+					else
+					{
+						filed[first_filed[ty * across + tx]++] = f;
+					}
+				}
+			}
+		}
+
+		if (pass == 0)
+		{
+			for (int t = 0; t < across * down; t++)
+			{
+				first_filed[t + 1] += first_filed[t];
+			}
+			filed.resize(first_filed[across * down]);
+		}
+	}
+
+	// Filling moved every tile's offset up to where the next one starts, so shift them back down
+	for (int t = across * down; t > 0; t--)
+	{
+		first_filed[t] = first_filed[t - 1];
+	}
+	first_filed[0] = 0;
+
+	// Tiles never share a cell, so nobody needs a lock; a cell right on a side gets filled by both triangles, with the same value give or take rounding
+	RunChunks(tasks.get(), across * down, [this, values, &grid, mode, across, &faces, &corners, &first_filed, &filed](int begin, int end)
+	{
+		EdgeList cavity;
+		EdgeList stack;
+		for (int t = begin; t < end; t++)
+		{
+			for (int k = first_filed[t]; k < first_filed[t + 1]; k++)
+			{
+				int f = filed[k];
+				RasterFace(faces[f], &corners[3 * f], values, grid, mode, t % across, t / across, cavity, stack);
+			}
+		}
+	});
+}
+
 //	--------------------------------------------------------
 
 #endif
\ No newline at end of file